@@ -42,6 +42,7 @@ Keypad::Keypad(char *userKeymap, byte *row, byte *col, byte numRows, byte numCol
 
 	setDebounceTime(10);
 	setHoldTime(500);
+	setRepeatRate(0, 0, 0);
 	keypadEventListener = 0;
 
 	startTime = 0;
@@ -57,7 +58,8 @@ void Keypad::begin(char *userKeymap) {
 char Keypad::getKey() {
 	single_key = true;
 
-	if (getKeys() && key[0].stateChanged && (key[0].kstate==PRESSED))
+	// A held key reports again on every typematic repeat (see setRepeatRate).
+	if (getKeys() && key[0].stateChanged && (key[0].kstate==PRESSED || (key[0].kstate==HOLD && repeatStart)))
 		return key[0].kchar;
 	
 	single_key = false;
@@ -159,14 +161,24 @@ void Keypad::nextKeyState(byte idx, boolean button) {
 				holdTimer = millis(); }		// Get ready for next HOLD state.
 			break;
 		case PRESSED:
-			if ((millis()-holdTimer)>holdTime)	// Waiting for a key HOLD...
+			if ((millis()-holdTimer)>holdTime) {	// Waiting for a key HOLD...
 				transitionTo (idx, HOLD);
+				repeatTimer = millis();				// The HOLD itself is the first repeat.
+				repeatInterval = repeatStart; }
 			else if (button==OPEN)				// or for a key to be RELEASED.
 				transitionTo (idx, RELEASED);
 			break;
 		case HOLD:
 			if (button==OPEN)
 				transitionTo (idx, RELEASED);
+			else if (repeatStart && (millis()-repeatTimer)>=repeatInterval) {	// Typematic repeat.
+				key[idx].stateChanged = true;	// Reported without notifying the event listener.
+				repeatTimer = millis();
+				if (repeatInterval > repeatMin + repeatAccel)	// Each repeat comes a little sooner.
+					repeatInterval -= repeatAccel;
+				else
+					repeatInterval = repeatMin;
+			}
 			break;
 		case RELEASED:
 			transitionTo (idx, IDLE);
@@ -240,6 +252,21 @@ void Keypad::setHoldTime(uint hold) {
     holdTime = hold;
 }
 
+// Once a key reaches HOLD it repeats every startInterval mS, shrinking by acceleration
+// mS per repeat down to minInterval. Repeats are only checked while a key is held and
+// resolve to the debounce (scan) time. A startInterval of 0 disables repeat.
+void Keypad::setRepeatRate(uint startInterval, uint minInterval, uint acceleration) {
+	repeatStart = startInterval;
+	repeatMin = (minInterval<1 || minInterval>startInterval) ? startInterval : minInterval;
+	repeatAccel = acceleration;
+	repeatInterval = repeatStart;
+}
+
+// True when the key just returned by getKey() is a typematic repeat, not a new press.
+bool Keypad::keyRepeated() {
+	return key[0].kstate == HOLD;
+}
+
 void Keypad::addEventListener(void (*listener)(char)){
 	keypadEventListener = listener;
 }
@@ -266,6 +293,7 @@ void Keypad::transitionTo(byte idx, KeyState nextState) {
 
 /*
 || @changelog
+|| | 3.1 2026-10-18 - Troy Johnson     : Added typematic repeat with setRepeatRate() and keyRepeated().
 || | 3.1 2013-01-15 - Mark Stanley     : Fixed missing RELEASED & IDLE status when using a single key.
 || | 3.0 2012-07-12 - Mark Stanley     : Made library multi-keypress by default. (Backwards compatible)
 || | 3.0 2012-07-12 - Mark Stanley     : Modified pin functions to support Keypad_I2C
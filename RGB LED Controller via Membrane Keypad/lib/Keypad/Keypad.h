@@ -99,6 +99,8 @@ public:
 	bool isPressed(char keyChar);
 	void setDebounceTime(uint);
 	void setHoldTime(uint);
+	void setRepeatRate(uint startInterval, uint minInterval, uint acceleration);
+	bool keyRepeated();
 	void addEventListener(void (*listener)(char));
 	int findInList(char keyChar);
 	int findInList(int keyCode);
@@ -114,6 +116,11 @@ private:
 	KeypadSize sizeKpd;
 	uint debounceTime;
 	uint holdTime;
+	uint repeatStart;		// 0 disables typematic repeat.
+	uint repeatMin;
+	uint repeatAccel;
+	uint repeatInterval;
+	unsigned long repeatTimer;
 	bool single_key;
 
 	void scanKeys();
@@ -127,6 +134,7 @@ private:
 
 /*
 || @changelog
+|| | 3.1 2026-10-18 - Troy Johnson     : Added typematic repeat with setRepeatRate() and keyRepeated().
 || | 3.1 2013-01-15 - Mark Stanley     : Fixed missing RELEASED & IDLE status when using a single key.
 || | 3.0 2012-07-12 - Mark Stanley     : Made library multi-keypress by default. (Backwards compatible)
 || | 3.0 2012-07-12 - Mark Stanley     : Modified pin functions to support Keypad_I2C
@@ -9,18 +9,22 @@
  * Key Features:
  * - Static RGB Mode (A): Select predefined colors using the keypad (1-8).
  * - Random Color Mode (B): Automatically generates random RGB colors.
- * - Color Cycle Mode (C): Smooth transition through color spectrum with adjustable speed.
+ * - Color Cycle Mode (C): Smooth transition through color spectrum with adjustable speed
+ *   (1-9 presets, hold A/B to ramp slower/faster).
  * - Custom Color Mode (D): Input specific RGB values (0-255) for each color channel.
- * - Brightness Adjustment: Increase/decrease LED intensity in 25% increments.
+ * - Brightness Adjustment: Increase/decrease LED intensity, hold the key to ramp smoothly.
  * - Flashing Patterns: Cycle through LED colors at fixed intervals.
  * - State Preservation: Maintains LED state across mode changes.
  * - Reset Function: Hold * key for 2 seconds to reset to standby mode.
+ * - Idle Sleep: CPU idles between timer ticks while PWM keeps the LED lit.
+ * - Warm Boot: Colour and mode survive brown-out and watchdog resets (no standby replay).
+ * - Colour Calibration: Per-channel gain/gamma and a colour matrix, set over serial ("cal").
  * 
  * Controls:
  * - A-D: Mode selection
  * - 0-9: Mode-specific functions
  * - *: Reset to standby (long press)
- * - #: Confirm value in custom color mode
+ * - #: Confirm value in custom color mode, print power stats from main menu
  * 
  * Future If Revisting Plans:
  * - Implement EEPROM (Electrical Erasable Read-Only Memory) memory to save last selected mode and colors. Most likely to use external EEPROM.
@@ -28,7 +32,7 @@
  * - Expand custom patterns and effects library.
  * - Add sound reactivity mode.
  * 
- * Last Updated: May 26, 2025
+ * Last Updated: October 18, 2026
  */
 
 /*
@@ -45,16 +49,30 @@
  *   - Implemented long-press reset functionality
  *   - Added state preservation in staticRGB mode
  *   - Improved error handling and user feedback
+ * - October 18, 2026: Added SLEEP_MODE_IDLE between ticks in every polling loop,
+ *   with sleep/awake counters reported by # from the main menu.
+ * - October 18, 2026: Replaced the per-mode while loops and switch statements with
+ *   menu and key binding tables in PROGMEM, walked by a single non-blocking dispatcher.
+ *   Removed the unused callMode(), whose A-D mapping disagreed with loop().
+ * - October 18, 2026: Added warm boot from checksummed .noinit RAM and a 2 s hardware
+ *   watchdog. Standby now only plays on a cold power-on.
+ * - October 18, 2026: Added per-channel calibration lookup tables in the output stage,
+ *   loadable over serial and persisted in EEPROM. Linear until calibrated.
+ * - October 18, 2026: Brightness and cycle speed ramp with the keypad's new typematic
+ *   repeat instead of fixed 25% / preset steps.
  */
 
 #include <Arduino.h>
 #include <Keypad.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include <EEPROM.h>
 
 // RGB LED Pins & Values
 #define redTLED 13
 #define greenTLED 12
 #define blueTLED 11
-int redVal = 0, greenVal = 0, blueVal = 0;  // Initialize to off state
+int redVal = 255, greenVal = 255, blueVal = 255;  // Full level; currentState starts all off
 
 
 
@@ -82,492 +100,900 @@ struct LEDState {
 }; 
 LEDState currentState = {false, false, false};
 
+// Function prototypes
+void applyLEDState(LEDState state);
+void errorFlash();
+
+/*----------------------------------------------------------------------------------------------*/
+// Idle sleep accounting. The keypad pins (22-37) have no pin change interrupt on the
+// Mega, so the wake source is Timer0's overflow (the millis() tick, every ~1.024 ms).
+// Idle mode keeps Timer0/Timer1 running, so PWM on the LED pins is unaffected.
+unsigned long sleepMicros = 0;    // Time spent asleep
+unsigned long awakeMicros = 0;    // Time spent running between sleeps
+unsigned long sleepCount = 0;     // Number of sleeps
+unsigned long longestSleep = 0;   // Worst-case wake latency, should stay within one tick
+
+void idleUntilNextTick() {
+    static unsigned long lastWake = 0;
+    unsigned long sleepStart = micros();
+    awakeMicros += sleepStart - lastWake;
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    sleep_enable();
+    sei();        // The instruction after sei always runs, so no wake-up can be missed
+    sleep_cpu();
+    sleep_disable();
+
+    lastWake = micros();
+    unsigned long slept = lastWake - sleepStart;
+    sleepMicros += slept;
+    if (slept > longestSleep) longestSleep = slept;
+    sleepCount++;
+}
+
+bool printPowerStats(char) {
+    unsigned long total = sleepMicros + awakeMicros;
+    Serial.print(F("Asleep: "));
+    Serial.print(total >= 100 ? sleepMicros / (total / 100) : 0);
+    Serial.print(F("% | Sleeps: "));
+    Serial.print(sleepCount);
+    Serial.print(F(" | Longest sleep (us): "));
+    Serial.println(longestSleep);
+
+    // Start a new measurement window
+    sleepMicros = awakeMicros = sleepCount = longestSleep = 0;
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------*/
+// Menu and mode descriptor tables. Every menu is also the mode the controller is in, so
+// one table describes what gets printed, which keys do what, and where each key leads.
+// Both tables live in PROGMEM and are walked by dispatchKey() and enterMenu().
+enum MenuId : uint8_t {
+    MENU_MAIN,
+    MENU_STATIC,
+    MENU_BRIGHTNESS,
+    MENU_FLASH,
+    MENU_RANDOM,
+    MENU_CYCLE,
+    MENU_CUSTOM,
+    MENU_STANDBY,
+    MENU_COUNT
+};
+#define MENU_STAY   0xFF  // Remain in the current menu
+#define MENU_PARENT 0xFE  // Return to the current menu's parent
+
+// Full keypad range in ASCII order: '#', '*', '0'-'9', 'A'-'D'
+#define KEY_ANY_FIRST '#'
+#define KEY_ANY_LAST  'D'
+
+typedef bool (*KeyAction)(char key);         // Return false to stay in the current menu
+typedef void (*ModeTick)(unsigned long now); // Runs on every pass of loop() while active
+
+struct MenuDesc {
+    const char *title;  // PROGMEM, NULL for menus that print nothing on entry
+    uint8_t parent;
+    void (*enter)();    // Resets the mode's state, may be NULL
+    ModeTick tick;      // May be NULL
+};
+
+struct KeyBinding {
+    uint8_t menu;
+    char first;         // Keys first..last trigger this binding
+    char last;
+    const char *label;  // PROGMEM, printed in the menu listing and when triggered
+    KeyAction action;   // May be NULL
+    uint8_t next;       // Menu entered after the action, or MENU_STAY / MENU_PARENT
+    bool repeat;        // Also fires on typematic repeats while the key is held
+};
+
+uint8_t currentMenu = MENU_MAIN;
+unsigned long modeMillis = 0;  // Timestamp of the active mode's last step
+
+// Pre-defined colors stored in PROGMEM to save dynamic memory. Keys 1-8 in the static
+// menu index this table and static flash cycles through the first seven entries.
+const uint8_t PROGMEM presetColors[][3] = {
+    {1, 0, 0}, // Red
+    {0, 1, 0}, // Green
+    {0, 0, 1}, // Blue
+    {1, 1, 0}, // Yellow
+    {0, 1, 1}, // Cyan
+    {1, 0, 1}, // Magenta
+    {1, 1, 1}, // White
+    {0, 0, 0}  // Off
+};
+#define FLASH_COLORS 7
+
+unsigned long cycleInterval = 100; // Default speed
+const unsigned long CYCLE_STEP = 5;       // Per press or repeat of A/B, hold to ramp
+const unsigned long CYCLE_FASTEST = 5;
+const unsigned long CYCLE_SLOWEST = 250;  // Fits the uint8_t in SavedState
+float cycleHue = 0;
+
+/*----------------------------------------------------------------------------------------------*/
+// Warm boot state. The last colour and mode are mirrored into .noinit RAM, which the C
+// runtime leaves untouched on reset, so a brown-out or watchdog reset can relight the
+// LED from setup() instead of waiting in standby. The checksum rejects the random
+// contents SRAM powers up with; a power-on reset flag rejects it outright.
+#define STANDBY_ON_WARM_BOOT 0  // Set to 1 to play the standby animation after every reset
+#define SAVED_STATE_MAGIC 0xB007
+
+// Where the reset cause is found. MCUSR is only intact if no bootloader ran before us:
+// the stock Mega 2560 bootloader (stk500v2) clears it and hands nothing over, so after
+// it the flags read 0 and the magic and checksum alone reject a cold SRAM (about 1 in
+// 2^24 passes by chance). Optiboot and urboot pass the flags in r2; some bootloaders
+// leave them in GPIOR0. setup() prints what was found, to check this on a given board.
+#define RESET_FLAGS_MCUSR 0
+#define RESET_FLAGS_R2 1
+#define RESET_FLAGS_GPIOR0 2
+#ifndef RESET_FLAGS_FROM
+#define RESET_FLAGS_FROM RESET_FLAGS_MCUSR
+#endif
+
+struct SavedState {
+    uint16_t magic;
+    uint8_t menu;
+    uint8_t shown[3];     // Colour currently on the LED
+    uint8_t levels[3];    // redVal, greenVal, blueVal
+    LEDState leds;        // Static RGB channel mask
+    uint8_t cycleInterval;
+    float cycleHue;
+    uint8_t checksum;
+};
+SavedState savedState __attribute__((section(".noinit")));
+uint8_t resetFlags __attribute__((section(".noinit")));
+
+// Runs from .init3, before the C runtime and before any bootloader-left watchdog can
+// fire again: capture and clear the reset cause, then stop the watchdog. r2 still holds
+// what the bootloader left in it; the startup code only uses r1 before here.
+void captureResetFlags() __attribute__((naked, used, section(".init3")));
+void captureResetFlags() {
+    uint8_t flags = MCUSR;
+#if RESET_FLAGS_FROM == RESET_FLAGS_R2
+    uint8_t handedOver;
+    __asm__ __volatile__("mov %0, r2" : "=r"(handedOver));
+    flags |= handedOver;
+#elif RESET_FLAGS_FROM == RESET_FLAGS_GPIOR0
+    flags |= GPIOR0;
+#endif
+    resetFlags = flags;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+uint8_t checksum(const void *data, uint8_t length) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint8_t sum = 0x5A;
+    for (uint8_t i = 0; i < length; i++) {
+        sum = (sum << 1 | sum >> 7) ^ bytes[i];  // Rotate-xor, cheap and order sensitive
+    }
+    return sum;
+}
+
+uint8_t savedStateChecksum() {
+    return checksum(&savedState, offsetof(SavedState, checksum));
+}
+
+void saveState() {
+    savedState.magic = SAVED_STATE_MAGIC;
+    savedState.menu = currentMenu;
+    savedState.levels[0] = redVal;
+    savedState.levels[1] = greenVal;
+    savedState.levels[2] = blueVal;
+    savedState.leds = currentState;
+    savedState.cycleInterval = cycleInterval;
+    savedState.cycleHue = cycleHue;
+    savedState.checksum = savedStateChecksum();
+}
+
+/*----------------------------------------------------------------------------------------------*/
+// Colour calibration. The red, green and blue dies differ in efficiency, so each channel
+// gets its own gain and gamma, plus an optional 3x3 matrix to correct crosstalk between
+// channels. Everything is folded into one 8-to-16-bit table per channel, so the output
+// stage costs a table read per channel. Entries are scaled so 255 * 256 is full duty.
+// The default is linear on every channel, so output is unchanged until calibrated.
+#define CALIBRATION_MAGIC 0xCA1D
+#define CALIBRATION_ADDRESS 0  // EEPROM address
+
+struct Calibration {
+    uint16_t magic;
+    uint8_t gain[3];        // 255 = full output
+    uint8_t gamma[3];       // Gamma x10, output = input ^ (1 / gamma), 10 = linear
+    bool useMatrix;
+    int16_t matrix[3][3];   // Q8 (256 = 1.0), row = output channel, column = input channel
+    uint8_t checksum;       // Set when saved, so a save cut short by power loss is not loaded
+};
+const Calibration PROGMEM defaultCalibration = {
+    CALIBRATION_MAGIC,
+    {255, 255, 255},
+    {10, 10, 10},
+    false,
+    {{256, 0, 0}, {0, 256, 0}, {0, 0, 256}},
+    0
+};
+Calibration calibration;
+uint16_t calibrationLUT[3][256];
+bool calibrationReady = false;  // Tables are built after the warm boot relight
+
+uint16_t calibrateLevel(uint8_t channel, uint8_t value) {
+    float linear = pow(value / 255.0f, 10.0f / calibration.gamma[channel]);
+    return (uint16_t)(linear * calibration.gain[channel] * 256.0f + 0.5f);
+}
+
+void buildCalibrationLUTs() {
+    for (uint8_t channel = 0; channel < 3; channel++) {
+        for (int value = 0; value < 256; value++) {
+            calibrationLUT[channel][value] = calibrateLevel(channel, value);
+        }
+    }
+    calibrationReady = true;
+}
+
+void loadCalibration() {
+    EEPROM.get(CALIBRATION_ADDRESS, calibration);
+    if (calibration.magic != CALIBRATION_MAGIC ||
+        calibration.checksum != checksum(&calibration, offsetof(Calibration, checksum))) {
+        memcpy_P(&calibration, &defaultCalibration, sizeof(calibration));
+    }
+}
+
+// Final output stage, every LED write goes through here
+void outputLEDs(uint8_t red, uint8_t green, uint8_t blue) {
+    uint8_t in[3] = {red, green, blue};
+    uint8_t out[3];
+
+    for (uint8_t channel = 0; channel < 3; channel++) {
+        uint8_t value = in[channel];
+        if (calibration.useMatrix) {
+            long mixed = 128;
+            for (uint8_t k = 0; k < 3; k++) mixed += (long)calibration.matrix[channel][k] * in[k];
+            value = constrain(mixed >> 8, 0, 255);
+        }
+        uint16_t level = calibrationReady ? calibrationLUT[channel][value]
+                                          : calibrateLevel(channel, value);
+        out[channel] = (level + 128) >> 8;
+    }
+
+    analogWrite(redTLED, out[0]);
+    analogWrite(greenTLED, out[1]);
+    analogWrite(blueTLED, out[2]);
+}
+
+// Shows a colour and remembers it as the one to restore
+void writeLEDs(uint8_t red, uint8_t green, uint8_t blue) {
+    outputLEDs(red, green, blue);
+    savedState.shown[0] = red;
+    savedState.shown[1] = green;
+    savedState.shown[2] = blue;
+    saveState();
+}
+
+// Relights the LED from the saved state and returns the menu to resume, or
+// MENU_STANDBY on a cold start
+uint8_t restoreState() {
+    if (STANDBY_ON_WARM_BOOT || (resetFlags & _BV(PORF)) ||
+        savedState.magic != SAVED_STATE_MAGIC ||
+        savedState.checksum != savedStateChecksum() ||
+        savedState.menu >= MENU_COUNT) {
+        return MENU_STANDBY;
+    }
+
+    // Modes part-way through input or a submenu resume at their parent
+    uint8_t menu = savedState.menu;
+    if (menu == MENU_CUSTOM) menu = MENU_MAIN;
+    if (menu == MENU_BRIGHTNESS) menu = MENU_STATIC;
+
+    // Copy everything out before writeLEDs() re-saves the state
+    redVal = savedState.levels[0];
+    greenVal = savedState.levels[1];
+    blueVal = savedState.levels[2];
+    currentState = savedState.leds;
+    cycleInterval = savedState.cycleInterval;
+    cycleHue = savedState.cycleHue;
+    if (menu != MENU_STANDBY) {
+        writeLEDs(savedState.shown[0], savedState.shown[1], savedState.shown[2]);
+    }
+    return menu;
+}
 /*----------------------------------------------------------------------------------------------*/
-void standby() {
-    static unsigned long previousMillis = 0;
+void standbyEnter() {
+    writeLEDs(0, 0, 0);
+}
+
+void standbyTick(unsigned long currentMillis) {
     static int currentPhase = 0; // 0=initial flash, 1=delay, 2=fade in, 3=fade out
     static int flashCount = 0;
     static int fadeValue = 0;
-    static bool shouldExit = false;
     const unsigned long FLASH_INTERVAL = 250;
     const unsigned long FADE_INTERVAL = 10;
-    
-    while (!shouldExit) {
-        customKey = customKeypad.getKey();
-        if (customKey != NO_KEY) {
-            Serial.println("Standby Cancelled");
-            shouldExit = true;
-            break;
-        }
-        
-        unsigned long currentMillis = millis();
-        
-        switch(currentPhase) {
-            case 0: // Initial flash sequence
-                if (currentMillis - previousMillis >= FLASH_INTERVAL) {
-                    previousMillis = currentMillis;
-                    if ((flashCount % 2) == 0) {
-                        digitalWrite(redTLED, HIGH);
-                        digitalWrite(greenTLED, HIGH);
-                        digitalWrite(blueTLED, HIGH);
-                    } else {
-                        digitalWrite(redTLED, LOW);
-                        digitalWrite(greenTLED, LOW);
-                        digitalWrite(blueTLED, LOW);
-                    }
-                    flashCount++;
-                    if (flashCount >= 6) { // 3 complete cycles
-                        currentPhase = 1;
-                        previousMillis = currentMillis; // Reset timer for delay
-                    }
+
+    if (modeMillis == 0) { // Fresh entry, restart the sequence
+        currentPhase = 0;
+        flashCount = 0;
+        fadeValue = 0;
+    }
+
+    switch(currentPhase) {
+        case 0: // Initial flash sequence
+            if (currentMillis - modeMillis >= FLASH_INTERVAL) {
+                modeMillis = currentMillis;
+                if ((flashCount % 2) == 0) {
+                    writeLEDs(255, 255, 255);
+                } else {
+                    writeLEDs(0, 0, 0);
                 }
-                break;
-                
-            case 1: // Delay phase
-                if (currentMillis - previousMillis >= 1000) {
-                    currentPhase = 2;
-                    previousMillis = currentMillis;
+                flashCount++;
+                if (flashCount >= 6) { // 3 complete cycles
+                    currentPhase = 1;
                 }
-                break;
-                
-            case 2: // Fade in
-                if (currentMillis - previousMillis >= FADE_INTERVAL) {
-                    previousMillis = currentMillis;
-                    analogWrite(redTLED, fadeValue);
-                    analogWrite(greenTLED, fadeValue);
-                    analogWrite(blueTLED, fadeValue);
-                    fadeValue++;
-                    if (fadeValue > 255) {
-                        currentPhase = 3;
-                        fadeValue = 255;
-                    }
+            }
+            break;
+
+        case 1: // Delay phase
+            if (currentMillis - modeMillis >= 1000) {
+                currentPhase = 2;
+                modeMillis = currentMillis;
+            }
+            break;
+
+        case 2: // Fade in
+            if (currentMillis - modeMillis >= FADE_INTERVAL) {
+                modeMillis = currentMillis;
+                writeLEDs(fadeValue, fadeValue, fadeValue);
+                fadeValue++;
+                if (fadeValue > 255) {
+                    currentPhase = 3;
+                    fadeValue = 255;
                 }
-                break;
-                
-            case 3: // Fade out
-                if (currentMillis - previousMillis >= FADE_INTERVAL) {
-                    previousMillis = currentMillis;
-                    analogWrite(redTLED, fadeValue);
-                    analogWrite(greenTLED, fadeValue);
-                    analogWrite(blueTLED, fadeValue);
-                    fadeValue--;
-                    if (fadeValue < 0) {
-                        currentPhase = 2;
-                        fadeValue = 0;
-                    }
+            }
+            break;
+
+        case 3: // Fade out
+            if (currentMillis - modeMillis >= FADE_INTERVAL) {
+                modeMillis = currentMillis;
+                writeLEDs(fadeValue, fadeValue, fadeValue);
+                fadeValue--;
+                if (fadeValue < 0) {
+                    currentPhase = 2;
+                    fadeValue = 0;
                 }
-                break;
-        }
+            }
+            break;
     }
 }
 
+//Flashes LED as a solid white color so we know it's wired correctly
+bool standbyExit(char) {
+    Serial.println(F("Standby Cancelled"));
+    writeLEDs(255, 255, 255);
+    return true;
+}
+
+// Invalid input flashes the LED red three times, then puts the shown colour back.
+// The flash goes through the output stage but is not saved, so a reset mid-flash
+// restores the colour rather than the flash.
+const unsigned long ERROR_FLASH_INTERVAL = 250;
+uint8_t errorFlashPhases = 0;  // Red and off phases still to run
+unsigned long errorFlashMillis = 0;
+
 void errorFlash() {
-    static unsigned long previousMillis = 0;
-    static int flashCount = 0;
-    static bool ledState = false;
-    
-    unsigned long currentMillis = millis();
-    if (currentMillis - previousMillis >= 250) {
-        previousMillis = currentMillis;
-        ledState = !ledState;
-        digitalWrite(redTLED, ledState);
-        if (!ledState) flashCount++;
-        
-        if (flashCount >= 3) {
-            digitalWrite(redTLED, LOW);
-            flashCount = 0;
-            return;
-        }
-    }
+    errorFlashPhases = 6;
+    errorFlashMillis = millis() - ERROR_FLASH_INTERVAL;  // First phase on the next pass
 }
 
-void callMode(){
-  if(customKey == 'A') {
-    Serial.println("Static RGB Mode Selected");
-    staticRGB();
-  } else if (customKey == 'B') {
-    Serial.println("Brightness Mode Selected");
-    brightness();
-  } else if (customKey == 'C') {
-    Serial.println("Static Flash Mode Selected");
-    staticFlash();
-  } else if (customKey == 'D') {
-    Serial.println("Exiting to Main Menu");
-    return; // Exit to main menu
-  } else {
-    Serial.println("Invalid Input. Please try again.");
-    errorFlash(); // Flash red LED for invalid input
-  }
-  
+void endErrorFlash() {
+    if (errorFlashPhases == 0) return;
+    errorFlashPhases = 0;
+    outputLEDs(savedState.shown[0], savedState.shown[1], savedState.shown[2]);
+}
+
+void errorFlashTick(unsigned long currentMillis) {
+    if (errorFlashPhases == 0 || currentMillis - errorFlashMillis < ERROR_FLASH_INTERVAL) return;
+    errorFlashMillis = currentMillis;
+    errorFlashPhases--;
+    if (errorFlashPhases == 0) {
+        outputLEDs(savedState.shown[0], savedState.shown[1], savedState.shown[2]);
+    } else if (errorFlashPhases % 2) {
+        outputLEDs(255, 0, 0);
+    } else {
+        outputLEDs(0, 0, 0);
+    }
 }
 /*----------------------------------------------------------------------------------------------*/
-void brightness(){
-    Serial.println(F("Brightness Key Pressed"));
-    Serial.println(F("Press 1. to Increase Brightness"));
-    Serial.println(F("Press 2. to Decrease Brightness"));
-    Serial.println(F("Press 3. to Exit Brightness Menu"));
-    Serial.println(F("Modes (A-D) will also exit menu"));
-    
-    const int STEP = 64;  // 25% of 255
-    float ratios[3] = {0}; // Store color ratios
-    
+const int BRIGHTNESS_STEP = 8;  // Per press or repeat, hold to ramp
+float brightnessRatios[3] = {0}; // Store color ratios
+int brightnessMax = 0;
+
+void brightnessEnter() {
     // Calculate initial color ratios if any color is non-zero
-    int maxVal = max(max(redVal, greenVal), blueVal);
-    if (maxVal > 0) {
-        ratios[0] = (float)redVal / maxVal;
-        ratios[1] = (float)greenVal / maxVal;
-        ratios[2] = (float)blueVal / maxVal;
+    brightnessMax = max(max(redVal, greenVal), blueVal);
+    if (brightnessMax > 0) {
+        brightnessRatios[0] = (float)redVal / brightnessMax;
+        brightnessRatios[1] = (float)greenVal / brightnessMax;
+        brightnessRatios[2] = (float)blueVal / brightnessMax;
     }
-    
-    while (true) {
-        customKey = customKeypad.getKey();
-        if (!customKey) continue;
-        
-        switch(customKey) {
-            case '1': {
-                Serial.println(F("Increasing Brightness"));
-                int newMax = min(255, maxVal + STEP);
-                if (newMax != maxVal) {
-                    maxVal = newMax;
-                    // Apply ratios to maintain color balance
-                    redVal = round(ratios[0] * maxVal);
-                    greenVal = round(ratios[1] * maxVal);
-                    blueVal = round(ratios[2] * maxVal);
-                    applyLEDState(currentState);
-                }
-                break;
-            }
-            case '2': {
-                Serial.println(F("Decreasing Brightness"));
-                int newMax = max(0, maxVal - STEP);
-                if (newMax != maxVal) {
-                    maxVal = newMax;
-                    // Apply ratios to maintain color balance
-                    redVal = round(ratios[0] * maxVal);
-                    greenVal = round(ratios[1] * maxVal);
-                    blueVal = round(ratios[2] * maxVal);
-                    applyLEDState(currentState);
-                }
-                break;
-            }
-            case '3':
-            case 'A':
-            case 'B':
-            case 'C':
-            case 'D':
-                Serial.println(F("Exiting Brightness Menu"));
-                return;
-            default:
-                Serial.println(F("Invalid Input"));
-                errorFlash();
-        }
+}
+
+void setBrightness(int newMax) {
+    newMax = constrain(newMax, 0, 255);
+    if (newMax != brightnessMax) {
+        brightnessMax = newMax;
+        // Apply ratios to maintain color balance
+        redVal = round(brightnessRatios[0] * brightnessMax);
+        greenVal = round(brightnessRatios[1] * brightnessMax);
+        blueVal = round(brightnessRatios[2] * brightnessMax);
+        applyLEDState(currentState);
     }
 }
+
+bool brightnessUp(char) {
+    setBrightness(brightnessMax + BRIGHTNESS_STEP);
+    return true;
+}
+
+bool brightnessDown(char) {
+    setBrightness(brightnessMax - BRIGHTNESS_STEP);
+    return true;
+}
 /*----------------------------------------------------------------------------------------------*/
-void staticFlash() {
-    // Pre-defined states stored in PROGMEM to save dynamic memory
-    static const uint8_t PROGMEM states[][3] = {
-        {1, 0, 0}, // Red
-        {0, 1, 0}, // Green
-        {0, 0, 1}, // Blue
-        {1, 1, 0}, // Yellow
-        {0, 1, 1}, // Cyan
-        {1, 0, 1}, // Magenta
-        {1, 1, 1}  // White
-    };
-    
-    static unsigned long previousMillis = 0;
+void staticFlashTick(unsigned long currentMillis) {
     static uint8_t state = 0;
     const unsigned long interval = 1000;
 
-    while (true) {
-        customKey = customKeypad.getKey();
-        if (customKey != NO_KEY) {
-            Serial.println(F("Exiting Static Flash Mode"));
-            break;
-        }
+    if (currentMillis - modeMillis >= interval) {
+        modeMillis = currentMillis;
 
-        unsigned long currentMillis = millis();
-        if (currentMillis < previousMillis) {
-            previousMillis = currentMillis; // Handle overflow
-        }
-        
-        if (currentMillis - previousMillis >= interval) {
-            previousMillis = currentMillis;
-            
-            // Apply the current state
-            digitalWrite(redTLED, pgm_read_byte(&states[state][0]));
-            digitalWrite(greenTLED, pgm_read_byte(&states[state][1]));
-            digitalWrite(blueTLED, pgm_read_byte(&states[state][2]));
-            
-            state = (state + 1) % 7;
-        }
-    }
-}
+        // Apply the current state
+        writeLEDs(pgm_read_byte(&presetColors[state][0]) * 255,
+                  pgm_read_byte(&presetColors[state][1]) * 255,
+                  pgm_read_byte(&presetColors[state][2]) * 255);
 
-void printStaticRGBMenu() {
-    Serial.println("Static RGB Menu Options:");
-    Serial.println("1. Red LED On");
-    Serial.println("2. Green LED On");
-    Serial.println("3. Blue LED On");
-    Serial.println("4. Yellow LED On");
-    Serial.println("5. Cyan LED On");
-    Serial.println("6. Magenta LED On");
-    Serial.println("7. White LED On");
-    Serial.println("8. LED Off");
-    Serial.println("9. Static Flash Mode");
-    Serial.println("0. Brightness Menu");
-    Serial.println("A. Show Menu");
-    Serial.println("B/C/D. Exit to Main Menu");
+        state = (state + 1) % FLASH_COLORS;
+    }
 }
 
 void applyLEDState(LEDState state) {
     // Apply LED states with brightness preservation
-    if (state.red) {
-        analogWrite(redTLED, redVal);
-    } else {
-        analogWrite(redTLED, 0);
+    writeLEDs(state.red ? redVal : 0, state.green ? greenVal : 0, state.blue ? blueVal : 0);
+}
+
+bool setStaticColor(char key) {
+    uint8_t index = key - '1';
+    currentState.red = pgm_read_byte(&presetColors[index][0]);
+    currentState.green = pgm_read_byte(&presetColors[index][1]);
+    currentState.blue = pgm_read_byte(&presetColors[index][2]);
+    applyLEDState(currentState);
+    return true;
+}
+
+bool showMenu(char);
+/*----------------------------------------------------------------------------------------------*/
+void randomColorTick(unsigned long currentMillis) {
+    const unsigned long interval = 2000; // Change color every 2 seconds
+
+    if (modeMillis == 0 || currentMillis - modeMillis >= interval) {
+        modeMillis = currentMillis;
+
+        // Generate random RGB values
+        redVal = random(256);
+        greenVal = random(256);
+        blueVal = random(256);
+
+        writeLEDs(redVal, greenVal, blueVal);
     }
-    if (state.green) {
-        analogWrite(greenTLED, greenVal);
-    } else {
-        analogWrite(greenTLED, 0);
+}
+/*----------------------------------------------------------------------------------------------*/
+void colorCycleEnter() {
+    // Start each cycle from red
+    cycleHue = 0;
+}
+
+void reportCycleSpeed() {
+    saveState();
+    if (customKeypad.keyRepeated()) return; // Keep the serial line quiet while ramping
+    Serial.print(F("Speed set to: "));
+    Serial.println(cycleInterval);
+}
+
+bool setCycleSpeed(char key) {
+    cycleInterval = (10 - (key - '0')) * 25; // Finer speed control
+    reportCycleSpeed();
+    return true;
+}
+
+bool cycleSlower(char) {
+    cycleInterval = min(cycleInterval + CYCLE_STEP, CYCLE_SLOWEST);
+    reportCycleSpeed();
+    return true;
+}
+
+bool cycleFaster(char) {
+    cycleInterval = max(cycleInterval, CYCLE_FASTEST + CYCLE_STEP) - CYCLE_STEP;
+    reportCycleSpeed();
+    return true;
+}
+
+void colorCycleTick(unsigned long currentMillis) {
+    const float HUE_STEP = 0.5; // Smaller step for smoother transitions
+    const float GAMMA = 2.2; // The cycle's own curve, ahead of the calibration stage
+
+    if (currentMillis - modeMillis >= cycleInterval) {
+        modeMillis = currentMillis;
+        
+        // Update hue with smoother step
+        cycleHue += HUE_STEP;
+        if (cycleHue >= 360) cycleHue = 0;
+        
+        // Improved HSV to RGB conversion
+        float h = cycleHue / 60.0f;
+        float s = 1.0f; // Full saturation
+        float v = 1.0f; // Full value/brightness
+        
+        float c = v * s;
+        float x = c * (1 - abs(fmod(h, 2.0f) - 1));
+        float m = v - c;
+        
+        float r, g, b;
+        if (h < 1) {
+            r = c; g = x; b = 0;
+        } else if (h < 2) {
+            r = x; g = c; b = 0;
+        } else if (h < 3) {
+            r = 0; g = c; b = x;
+        } else if (h < 4) {
+            r = 0; g = x; b = c;
+        } else if (h < 5) {
+            r = x; g = 0; b = c;
+        } else {
+            r = c; g = 0; b = x;
+        }
+        
+        // Apply gamma correction and scale to 0-255; per-channel calibration comes after
+        redVal = round(pow((r + m), 1.0/GAMMA) * 255);
+        greenVal = round(pow((g + m), 1.0/GAMMA) * 255);
+        blueVal = round(pow((b + m), 1.0/GAMMA) * 255);
+        
+        writeLEDs(redVal, greenVal, blueVal);
     }
-    if (state.blue) {
-        analogWrite(blueTLED, blueVal);
-    } else {
-        analogWrite(blueTLED, 0);
+}
+/*----------------------------------------------------------------------------------------------*/
+const char channelRed[] PROGMEM = "Red";
+const char channelGreen[] PROGMEM = "Green";
+const char channelBlue[] PROGMEM = "Blue";
+const char *const channelNames[] PROGMEM = {channelRed, channelGreen, channelBlue};
+
+int customValues[3] = {0, 0, 0}; // Store RGB values
+int customChannel = 0; // 0=Red, 1=Green, 2=Blue
+int customValue = 0;
+
+void customColorEnter() {
+    customChannel = 0;
+    customValue = 0;
+}
+
+bool customDigit(char key) {
+    int digit = key - '0';
+    customValue = customValue * 10 + digit;
+    if (customValue > 255) customValue = 255;
+    Serial.println(customValue);
+    return true;
+}
+
+// Returns true once all three channels are entered, which leaves the menu
+bool customConfirm(char) {
+    customValues[customChannel] = customValue;
+    Serial.print(F("Set "));
+    Serial.print((const __FlashStringHelper *)pgm_read_ptr(&channelNames[customChannel]));
+    Serial.print(F(" to: "));
+    Serial.println(customValue);
+
+    customChannel++;
+    customValue = 0;
+
+    if (customChannel > 2) {
+        redVal = customValues[0];
+        greenVal = customValues[1];
+        blueVal = customValues[2];
+
+        writeLEDs(redVal, greenVal, blueVal);
+
+        Serial.println(F("Custom color applied!"));
+        return true;
     }
+
+    Serial.print(F("Enter value for "));
+    Serial.print((const __FlashStringHelper *)pgm_read_ptr(&channelNames[customChannel]));
+    Serial.println(':');
+    return false;
 }
-void staticRGB() {
-    printStaticRGBMenu();
-    while (true) {
-        customKey = customKeypad.getKey();
-        
-        if (customKey) {
-            LEDState previousState = currentState; // Store current state before changes
-            
-            switch (customKey) {
-                case 'A':
-                    printStaticRGBMenu();
-                    break;
-                case '1':
-                    Serial.println("Red LED On");
-                    currentState = {true, false, false};
-                    break;
-                case '2':
-                    Serial.println("Green LED On");
-                    currentState = {false, true, false};
-                    break;
-                case '3':
-                    Serial.println("Blue LED On");
-                    currentState = {false, false, true};
-                    break;
-                case '4':
-                    Serial.println("Yellow LED On");
-                    currentState = {true, true, false};
-                    break;
-                case '5':
-                    Serial.println("Cyan LED On");
-                    currentState = {false, true, true};
-                    break;
-                case '6':
-                    Serial.println("Magenta LED On");
-                    currentState = {true, false, true};
-                    break;
-                case '7':
-                    Serial.println("White LED On");
-                    currentState = {true, true, true};
-                    break;
-                case '8':
-                    Serial.println("LED Off");
-                    currentState = {false, false, false};
-                    break;
-                case '9':
-                    staticFlash();
-                    Serial.println("Back to Static RGB Mode");
-                    break;
-                case '0':
-                    brightness();
-                    break;
-                case 'B':
-                case 'C':
-                case 'D':
-                    Serial.println("Exiting Static RGB Mode");
-                    return;
-                default:
-                    Serial.println("Invalid Input. Please try again.");
-                    errorFlash();
-                    currentState = previousState; // Restore previous state
+/*----------------------------------------------------------------------------------------------*/
+// Menu titles and key labels
+const char titleMain[] PROGMEM = "Main Menu";
+const char titleStatic[] PROGMEM = "Static RGB Menu";
+const char titleBrightness[] PROGMEM = "Brightness Menu";
+const char titleFlash[] PROGMEM = "Static Flash Mode";
+const char titleRandom[] PROGMEM = "Random Color Mode";
+const char titleCycle[] PROGMEM = "Color Cycle Mode";
+const char titleCustom[] PROGMEM = "Custom Color Mode (0-255 per color)";
+
+const char labelPowerStats[] PROGMEM = "Power Stats";
+const char labelRed[] PROGMEM = "Red LED On";
+const char labelGreen[] PROGMEM = "Green LED On";
+const char labelBlue[] PROGMEM = "Blue LED On";
+const char labelYellow[] PROGMEM = "Yellow LED On";
+const char labelCyan[] PROGMEM = "Cyan LED On";
+const char labelMagenta[] PROGMEM = "Magenta LED On";
+const char labelWhite[] PROGMEM = "White LED On";
+const char labelOff[] PROGMEM = "LED Off";
+const char labelShowMenu[] PROGMEM = "Show Menu";
+const char labelExitMain[] PROGMEM = "Exit to Main Menu";
+const char labelIncrease[] PROGMEM = "Increase Brightness (hold to ramp)";
+const char labelDecrease[] PROGMEM = "Decrease Brightness (hold to ramp)";
+const char labelExitBrightness[] PROGMEM = "Exit Brightness Menu";
+const char labelExit[] PROGMEM = "Exit";
+const char labelSpeed[] PROGMEM = "Set Speed";
+const char labelSlower[] PROGMEM = "Slower (hold to ramp)";
+const char labelFaster[] PROGMEM = "Faster (hold to ramp)";
+const char labelDigit[] PROGMEM = "Enter Digit";
+const char labelConfirm[] PROGMEM = "Confirm Value";
+const char labelCancel[] PROGMEM = "Cancel";
+
+const MenuDesc PROGMEM menus[MENU_COUNT] = {
+    /* MENU_MAIN       */ {titleMain,       MENU_MAIN,   NULL,              NULL},
+    /* MENU_STATIC     */ {titleStatic,     MENU_MAIN,   NULL,              NULL},
+    /* MENU_BRIGHTNESS */ {titleBrightness, MENU_STATIC, brightnessEnter,   NULL},
+    /* MENU_FLASH      */ {titleFlash,      MENU_STATIC, NULL,              staticFlashTick},
+    /* MENU_RANDOM     */ {titleRandom,     MENU_MAIN,   NULL,              randomColorTick},
+    /* MENU_CYCLE      */ {titleCycle,      MENU_MAIN,   colorCycleEnter,   colorCycleTick},
+    /* MENU_CUSTOM     */ {titleCustom,     MENU_MAIN,   customColorEnter,  NULL},
+    /* MENU_STANDBY    */ {NULL,            MENU_MAIN,   standbyEnter,      standbyTick},
+};
+
+// Bindings are grouped by menu and matched first to last, so specific keys go before
+// catch-all ranges. Keys that match nothing are reported as invalid input.
+const KeyBinding PROGMEM keyBindings[] = {
+    {MENU_MAIN,       'A', 'A', titleStatic,       NULL,             MENU_STATIC, false},
+    {MENU_MAIN,       'B', 'B', titleRandom,       NULL,             MENU_RANDOM, false},
+    {MENU_MAIN,       'C', 'C', titleCycle,        NULL,             MENU_CYCLE,  false},
+    {MENU_MAIN,       'D', 'D', titleCustom,       NULL,             MENU_CUSTOM, false},
+    {MENU_MAIN,       '#', '#', labelPowerStats,   printPowerStats,  MENU_STAY,   false},
+    {MENU_MAIN,       '*', '*', NULL,              NULL,             MENU_STAY,   false},  // Hold to reset
+
+    {MENU_STATIC,     '1', '1', labelRed,          setStaticColor,   MENU_STAY,   false},
+    {MENU_STATIC,     '2', '2', labelGreen,        setStaticColor,   MENU_STAY,   false},
+    {MENU_STATIC,     '3', '3', labelBlue,         setStaticColor,   MENU_STAY,   false},
+    {MENU_STATIC,     '4', '4', labelYellow,       setStaticColor,   MENU_STAY,   false},
+    {MENU_STATIC,     '5', '5', labelCyan,         setStaticColor,   MENU_STAY,   false},
+    {MENU_STATIC,     '6', '6', labelMagenta,      setStaticColor,   MENU_STAY,   false},
+    {MENU_STATIC,     '7', '7', labelWhite,        setStaticColor,   MENU_STAY,   false},
+    {MENU_STATIC,     '8', '8', labelOff,          setStaticColor,   MENU_STAY,   false},
+    {MENU_STATIC,     '9', '9', titleFlash,        NULL,             MENU_FLASH,  false},
+    {MENU_STATIC,     '0', '0', titleBrightness,   NULL,             MENU_BRIGHTNESS, false},
+    {MENU_STATIC,     'A', 'A', labelShowMenu,     showMenu,         MENU_STAY,   false},
+    {MENU_STATIC,     'B', 'D', labelExitMain,     NULL,             MENU_PARENT, false},
+
+    {MENU_BRIGHTNESS, '1', '1', labelIncrease,     brightnessUp,     MENU_STAY,   true},
+    {MENU_BRIGHTNESS, '2', '2', labelDecrease,     brightnessDown,   MENU_STAY,   true},
+    {MENU_BRIGHTNESS, '3', '3', labelExitBrightness, NULL,           MENU_PARENT, false},
+    {MENU_BRIGHTNESS, 'A', 'D', labelExitBrightness, NULL,           MENU_PARENT, false},
+
+    {MENU_FLASH,      KEY_ANY_FIRST, KEY_ANY_LAST, labelExit, NULL,  MENU_PARENT, false},
+
+    {MENU_RANDOM,     KEY_ANY_FIRST, KEY_ANY_LAST, labelExit, NULL,  MENU_PARENT, false},
+
+    {MENU_CYCLE,      '1', '9', labelSpeed,        setCycleSpeed,    MENU_STAY,   false},
+    {MENU_CYCLE,      'A', 'A', labelSlower,       cycleSlower,      MENU_STAY,   true},
+    {MENU_CYCLE,      'B', 'B', labelFaster,       cycleFaster,      MENU_STAY,   true},
+    {MENU_CYCLE,      KEY_ANY_FIRST, KEY_ANY_LAST, labelExit, NULL,  MENU_PARENT, false},
+
+    {MENU_CUSTOM,     '0', '9', labelDigit,        customDigit,      MENU_STAY,   false},
+    {MENU_CUSTOM,     '#', '#', labelConfirm,      customConfirm,    MENU_PARENT, false},
+    {MENU_CUSTOM,     '*', '*', labelCancel,       NULL,             MENU_PARENT, false},
+    {MENU_CUSTOM,     'A', 'D', NULL,              NULL,             MENU_STAY,   false},  // Ignored
+
+    {MENU_STANDBY,    KEY_ANY_FIRST, KEY_ANY_LAST, NULL, standbyExit,  MENU_PARENT, false},
+};
+#define KEY_BINDING_COUNT (sizeof(keyBindings) / sizeof(keyBindings[0]))
+
+/*----------------------------------------------------------------------------------------------*/
+void printMenuListing(uint8_t menu) {
+    KeyBinding binding;
+    for (uint8_t i = 0; i < KEY_BINDING_COUNT; i++) {
+        memcpy_P(&binding, &keyBindings[i], sizeof(binding));
+        if (binding.menu != menu || binding.label == NULL) continue;
+
+        if (binding.first == KEY_ANY_FIRST && binding.last == KEY_ANY_LAST) {
+            Serial.print(F("Any key"));
+        } else {
+            Serial.print(binding.first);
+            if (binding.last != binding.first) {
+                Serial.print('-');
+                Serial.print(binding.last);
             }
-            
-            // Apply the current state
-            applyLEDState(currentState);
         }
-        customKey = NO_KEY;
+        Serial.print(F(". "));
+        Serial.println((const __FlashStringHelper *)binding.label);
     }
 }
-/*----------------------------------------------------------------------------------------------*/
-void randomColor() {
-    Serial.println("Random Color Mode");
-    Serial.println("Press any key to exit");
-    
-    unsigned long previousMillis = 0;
-    const unsigned long interval = 2000; // Change color every 2 seconds
-    
-    while (true) {
-        customKey = customKeypad.getKey();
-        if (customKey != NO_KEY) {
-            Serial.println("Exiting Random Color Mode");
-            break;
+
+bool showMenu(char) {
+    printMenuListing(currentMenu);
+    return true;
+}
+
+// Switches to a menu, printing its title and (when descending) its key listing
+void enterMenu(uint8_t menu) {
+    MenuDesc desc;
+    memcpy_P(&desc, &menus[menu], sizeof(desc));
+    bool returning = (menu != currentMenu) &&
+                     (menu == pgm_read_byte(&menus[currentMenu].parent)) &&
+                     (pgm_read_ptr(&menus[currentMenu].title) != NULL);
+
+    endErrorFlash();
+    currentMenu = menu;
+    modeMillis = 0;
+    saveState();
+
+    if (desc.title != NULL) {
+        if (returning) Serial.print(F("Back to "));
+        Serial.println((const __FlashStringHelper *)desc.title);
+        if (!returning) printMenuListing(menu);
+    }
+    if (desc.enter != NULL) desc.enter();
+}
+
+// Looks up the key in the current menu's bindings and runs the matching entry.
+// Typematic repeats only reach bindings that ask for them.
+void dispatchKey(char key, bool repeated) {
+    KeyBinding binding;
+    for (uint8_t i = 0; i < KEY_BINDING_COUNT; i++) {
+        if (pgm_read_byte(&keyBindings[i].menu) != currentMenu) continue;
+        memcpy_P(&binding, &keyBindings[i], sizeof(binding));
+        if (key < binding.first || key > binding.last) continue;
+        if (repeated && !binding.repeat) return;
+        endErrorFlash();
+
+        // Keys that change menus are acknowledged by the next menu's title
+        if (binding.label != NULL && binding.next == MENU_STAY && binding.first == binding.last &&
+            !repeated) {
+            Serial.println((const __FlashStringHelper *)binding.label);
         }
-        
-        unsigned long currentMillis = millis();
-        if (currentMillis - previousMillis >= interval) {
-            previousMillis = currentMillis;
-            
-            // Generate random RGB values
-            redVal = random(256);
-            greenVal = random(256);
-            blueVal = random(256);
-            
-            analogWrite(redTLED, redVal);
-            analogWrite(greenTLED, greenVal);
-            analogWrite(blueTLED, blueVal);
+
+        bool proceed = (binding.action == NULL) || binding.action(key);
+        if (proceed && binding.next != MENU_STAY) {
+            enterMenu(binding.next == MENU_PARENT ? pgm_read_byte(&menus[currentMenu].parent)
+                                                  : binding.next);
         }
+        return;
     }
+
+    // A held key already got its one complaint on the press
+    if (repeated) return;
+    Serial.println(F("Invalid Input. Please try again."));
+    errorFlash(); // Flash red LED for invalid input
 }
 /*----------------------------------------------------------------------------------------------*/
-void colorCycle() {
-    Serial.println(F("Color Cycle Mode"));
-    Serial.println(F("Press 1-9 to adjust speed"));
-    Serial.println(F("Press any other key to exit"));
-    
-    static unsigned long previousMillis = 0;
-    static unsigned long interval = 100; // Default speed
-    static float hue = 0;
-    const float HUE_STEP = 0.5; // Smaller step for smoother transitions
-    const float GAMMA = 2.2; // Gamma correction factor
-    
-    while (true) {
-        customKey = customKeypad.getKey();
-        if (customKey) {
-            if (customKey >= '1' && customKey <= '9') {
-                interval = (10 - (customKey - '0')) * 25; // Finer speed control
-                Serial.print(F("Speed set to: "));
-                Serial.println(interval);
-            } else {
-                Serial.println(F("Exiting Color Cycle Mode"));
-                break;
-            }
-        }
-        
-        unsigned long currentMillis = millis();
-        if (currentMillis - previousMillis >= interval) {
-            previousMillis = currentMillis;
-            
-            // Update hue with smoother step
-            hue += HUE_STEP;
-            if (hue >= 360) hue = 0;
-            
-            // Improved HSV to RGB conversion
-            float h = hue / 60.0f;
-            float s = 1.0f; // Full saturation
-            float v = 1.0f; // Full value/brightness
-            
-            float c = v * s;
-            float x = c * (1 - abs(fmod(h, 2.0f) - 1));
-            float m = v - c;
-            
-            float r, g, b;
-            if (h < 1) {
-                r = c; g = x; b = 0;
-            } else if (h < 2) {
-                r = x; g = c; b = 0;
-            } else if (h < 3) {
-                r = 0; g = c; b = x;
-            } else if (h < 4) {
-                r = 0; g = x; b = c;
-            } else if (h < 5) {
-                r = x; g = 0; b = c;
-            } else {
-                r = c; g = 0; b = x;
-            }
-            
-            // Apply gamma correction and scale to 0-255
-            redVal = round(pow((r + m), 1.0/GAMMA) * 255);
-            greenVal = round(pow((g + m), 1.0/GAMMA) * 255);
-            blueVal = round(pow((b + m), 1.0/GAMMA) * 255);
-            
-            analogWrite(redTLED, redVal);
-            analogWrite(greenTLED, greenVal);
-            analogWrite(blueTLED, blueVal);
+// Holding * for HOLD_DURATION from any menu resets to standby
+void checkResetHold(char key, bool repeated, unsigned long currentMillis) {
+    static unsigned long keyPressStartTime = 0;
+    static bool keyWasPressed = false;
+    const unsigned long HOLD_DURATION = 2000; // 2 seconds for reset
+
+    if (key == '*' && !repeated) {
+        keyWasPressed = true;
+        keyPressStartTime = currentMillis;
+    } else if (keyWasPressed) {
+        KeyState state = customKeypad.getState();
+        if (state != PRESSED && state != HOLD) {
+            keyWasPressed = false;
+        } else if (currentMillis - keyPressStartTime >= HOLD_DURATION) {
+            keyWasPressed = false;
+            Serial.println(F("Resetting to standby mode..."));
+            enterMenu(MENU_STANDBY);
         }
     }
-    // Reset the hue for next time
-    hue = 0;
 }
 /*----------------------------------------------------------------------------------------------*/
-void customColor() {
-    int values[3] = {0, 0, 0}; // Store RGB values
-    int currentColor = 0; // 0=Red, 1=Green, 2=Blue
-    int currentValue = 0;
-    
-    Serial.println("Custom Color Mode");
-    Serial.println("Enter values (0-255) for each color");
-    Serial.println("Use # to confirm each value");
-    Serial.println("Press * to cancel");
-    
-    while (true) {
-        customKey = customKeypad.getKey();
-        
-        if (customKey) {
-            if (customKey == '*') {
-                Serial.println("Cancelled custom color input");
-                return;
-            }
-            
-            if (customKey == '#') {
-                values[currentColor] = currentValue;
-                Serial.print("Set ");
-                switch(currentColor) {
-                    case 0: Serial.print("Red"); break;
-                    case 1: Serial.print("Green"); break;
-                    case 2: Serial.print("Blue"); break;
-                }
-                Serial.print(" to: ");
-                Serial.println(currentValue);
-                
-                currentColor++;
-                currentValue = 0;
-                
-                if (currentColor > 2) {
-                    redVal = values[0];
-                    greenVal = values[1];
-                    blueVal = values[2];
-                    
-                    analogWrite(redTLED, redVal);
-                    analogWrite(greenTLED, greenVal);
-                    analogWrite(blueTLED, blueVal);
-                    
-                    
-                    Serial.println("Custom color applied!");
-                    return;
-                }
-                
-                Serial.print("Enter value for ");
-                switch(currentColor) {
-                    case 0: Serial.println("Red:"); break;
-                    case 1: Serial.println("Green:"); break;
-                    case 2: Serial.println("Blue:"); break;
-                }
-            }
-            else if (customKey >= '0' && customKey <= '9') {
-                int digit = customKey - '0';
-                currentValue = currentValue * 10 + digit;
-                if (currentValue > 255) currentValue = 255;
-                Serial.println(currentValue);
-            }
+// Serial calibration commands, one per line:
+//   cal                     Show the calibration
+//   cal gain <r> <g> <b>    Channel gain, 0-255
+//   cal gamma <r> <g> <b>   Channel gamma x10, e.g. 22 for 2.2
+//   cal matrix <9 values>   Row-major colour matrix in Q8 (256 = 1.0)
+//   cal matrix off          Disable the colour matrix
+//   cal save                Persist to EEPROM
+//   cal reset               Restore the defaults
+void printCalibration() {
+    Serial.print(F("Gain: "));
+    for (uint8_t i = 0; i < 3; i++) { Serial.print(calibration.gain[i]); Serial.print(' '); }
+    Serial.print(F("| Gamma x10: "));
+    for (uint8_t i = 0; i < 3; i++) { Serial.print(calibration.gamma[i]); Serial.print(' '); }
+    Serial.print(F("| Matrix: "));
+    if (!calibration.useMatrix) {
+        Serial.println(F("off"));
+        return;
+    }
+    for (uint8_t i = 0; i < 9; i++) {
+        Serial.print(calibration.matrix[i / 3][i % 3]);
+        Serial.print(i < 8 ? ' ' : '\n');
+    }
+}
+
+// Parses up to count integers from the rest of the line, returns how many were found
+uint8_t parseValues(char *text, long *values, uint8_t count) {
+    uint8_t found = 0;
+    char *end;
+    while (found < count) {
+        long value = strtol(text, &end, 10);
+        if (end == text) break;
+        values[found++] = value;
+        text = end;
+    }
+    return found;
+}
+
+void calibrationCommand(char *args) {
+    long values[9];
+    bool changed = false;
+
+    while (*args == ' ') args++;
+    if (*args == '\0') {
+        printCalibration();
+    } else if (strncmp_P(args, PSTR("gain "), 5) == 0 && parseValues(args + 5, values, 3) == 3) {
+        for (uint8_t i = 0; i < 3; i++) calibration.gain[i] = constrain(values[i], 0, 255);
+        changed = true;
+    } else if (strncmp_P(args, PSTR("gamma "), 6) == 0 && parseValues(args + 6, values, 3) == 3) {
+        for (uint8_t i = 0; i < 3; i++) calibration.gamma[i] = constrain(values[i], 1, 50);
+        changed = true;
+    } else if (strcmp_P(args, PSTR("matrix off")) == 0) {
+        calibration.useMatrix = false;
+        changed = true;
+    } else if (strncmp_P(args, PSTR("matrix "), 7) == 0 && parseValues(args + 7, values, 9) == 9) {
+        for (uint8_t i = 0; i < 9; i++) calibration.matrix[i / 3][i % 3] = constrain(values[i], -1024, 1024);
+        calibration.useMatrix = true;
+        changed = true;
+    } else if (strcmp_P(args, PSTR("save")) == 0) {
+        calibration.checksum = checksum(&calibration, offsetof(Calibration, checksum));
+        EEPROM.put(CALIBRATION_ADDRESS, calibration);
+        Serial.println(F("Calibration saved"));
+    } else if (strcmp_P(args, PSTR("reset")) == 0) {
+        memcpy_P(&calibration, &defaultCalibration, sizeof(calibration));
+        changed = true;
+    } else {
+        Serial.println(F("Usage: cal [gain r g b | gamma r g b | matrix 9 values | matrix off | save | reset]"));
+    }
+
+    if (changed) {
+        buildCalibrationLUTs();
+        writeLEDs(savedState.shown[0], savedState.shown[1], savedState.shown[2]);
+        printCalibration();
+    }
+}
+
+// Collects serial input into lines without blocking
+void pollSerialCommands() {
+    static char line[10 + 9 * 6 + 1];  // Longest command: "cal matrix" and nine " -1024"
+    static uint8_t length = 0;
+    static bool overflow = false;
+
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c == '\r') continue;
+        if (c != '\n') {
+            if (length < sizeof(line) - 1) line[length++] = c;
+            else overflow = true;
+            continue;
+        }
+        line[length] = '\0';
+        length = 0;
+
+        if (overflow) {
+            overflow = false;
+            Serial.println(F("Line too long"));
+        } else if (strncmp_P(line, PSTR("cal"), 3) == 0 && (line[3] == ' ' || line[3] == '\0')) {
+            calibrationCommand(line + 3);
+        } else if (line[0] != '\0') {
+            Serial.println(F("Unknown command"));
         }
     }
 }
@@ -577,73 +1003,45 @@ void setup() {
   pinMode(greenTLED, OUTPUT);
   pinMode(blueTLED, OUTPUT);
 
+  // Relight before anything slow runs; the LED is back within the first ms of setup()
+  loadCalibration();
+  uint8_t menu = restoreState();
+  buildCalibrationLUTs();
+
   Serial.begin(9600);
-  //Flashes LED as a solid white color so we know it's wired correctly
-  standby();
-  digitalWrite(redTLED, HIGH);
-  digitalWrite(greenTLED, HIGH);
-  digitalWrite(blueTLED, HIGH);
+  Serial.print(F("Reset flags: 0x"));
+  Serial.println(resetFlags, HEX);
+  customKeypad.setRepeatRate(150, 30, 15);  // After the 500 ms hold: 150 ms, speeding up to 30 ms
+  wdt_enable(WDTO_2S);  // Recover from hangs; loop() feeds it every pass
+
+  if (menu != MENU_STANDBY) {
+    float hue = cycleHue;  // Resume the colour cycle where it was
+    Serial.print(F("Warm boot, restored: "));
+    enterMenu(menu);
+    cycleHue = hue;
+  } else {
+    enterMenu(MENU_STANDBY);
+  }
 }
 
 void loop() {
-    static unsigned long keyPressStartTime = 0;
-    static bool keyWasPressed = false;
-    static bool resetTriggered = false;
-    const unsigned long HOLD_DURATION = 2000; // 2 seconds for reset
-    const unsigned long CHECK_INTERVAL = 50;  // Check every 50ms
-
     customKey = customKeypad.getKey();
     unsigned long currentMillis = millis();
 
-    // Handle long press of * for reset
-    if (customKey == '*') {
-        if (!keyWasPressed) {
-            keyWasPressed = true;
-            keyPressStartTime = currentMillis;
-            resetTriggered = false;
-        }
-        else if (!resetTriggered && (currentMillis - keyPressStartTime) >= HOLD_DURATION) {
-            resetTriggered = true;
-            Serial.println("Resetting to standby mode...");
-            digitalWrite(redTLED, LOW);
-            digitalWrite(greenTLED, LOW);
-            digitalWrite(blueTLED, LOW);
-            standby();
-            keyWasPressed = false;
-            return;
-        }
-    }
-    else {
-        keyWasPressed = false;
-        resetTriggered = false;
-    }    // Handle normal key presses
+    pollSerialCommands();
+    bool repeated = customKeypad.keyRepeated();
+    checkResetHold(customKey, repeated, currentMillis);
     if (customKey) {
-        Serial.print(F("Input: "));
-        Serial.println(customKey);
-        
-        switch(customKey) {
-            case 'A':
-                Serial.println(F("Static RGB Mode Selected"));
-                staticRGB();
-                break;
-            case 'B':
-                Serial.println(F("Random Color Mode Selected"));
-                randomColor();
-                break;
-            case 'C':
-                Serial.println(F("Color Cycle Mode Selected"));
-                colorCycle();
-                break;
-            case 'D':
-                Serial.println(F("Custom Color Mode Selected"));
-                customColor();
-                break;
-            default:
-                if (customKey != '*') { // Ignore * as it's used for reset
-                    Serial.println(F("Invalid Input. Please select a mode (A-D)"));
-                    errorFlash();
-                }
-                break;
-        }
+        dispatchKey(customKey, repeated);
     }
+
+    wdt_reset();
+
+    ModeTick tick = (ModeTick)pgm_read_ptr(&menus[currentMenu].tick);
+    if (tick != NULL) {
+        tick(currentMillis);
+    }
+    errorFlashTick(currentMillis);
+
+    idleUntilNextTick();
 }
@@ -0,0 +1,189 @@
+// Just enough of the Arduino core to build the keypad code on the host.
+//
+// Time only moves when a test calls hostAdvance(), when sleep_cpu() waits
+// for the next Timer0 tick (see avr/sleep.h), or when the code under test is
+// charged for something: hostCosts() holds a rough AVR cost per pin access
+// and per analogWrite(), both 0 unless a test sets them.
+//
+// The keypad matrix is modelled on the pins: hostHoldKey() joins a row pin
+// to a column pin, and the row reads LOW while that column is driven LOW.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define F_CPU 16000000UL
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue) ((bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define abs(x) ((x) > 0 ? (x) : -(x))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define _BV(bit) (1 << (bit))
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+#define memcpy_P memcpy
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+
+// Reset flags, as the .init3 code finds them
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+inline uint8_t &hostMCUSR() {
+  static uint8_t flags = 0;
+  return flags;
+}
+#define MCUSR hostMCUSR()
+#define GPIOR0 hostMCUSR()
+
+inline void cli() {}
+inline void sei() {}
+
+struct HostCosts {
+  unsigned pinUs = 0;          // pinMode(), digitalWrite(), digitalRead()
+  unsigned analogWriteUs = 0;
+};
+inline HostCosts &hostCosts() {
+  static HostCosts costs;
+  return costs;
+}
+
+inline unsigned long &hostMicros() {
+  static unsigned long now = 0;
+  return now;
+}
+inline void hostAdvance(unsigned long us) { hostMicros() += us; }
+inline unsigned long micros() { return hostMicros(); }
+inline unsigned long millis() { return hostMicros() / 1000; }
+
+inline uint8_t *hostPinLevels() {
+  static uint8_t levels[80];
+  return levels;
+}
+inline uint8_t *hostHeldKey() {  // Row pin and column pin, 0 for none
+  static uint8_t pins[2];
+  return pins;
+}
+inline void hostHoldKey(uint8_t rowPin, uint8_t columnPin) {
+  hostHeldKey()[0] = rowPin;
+  hostHeldKey()[1] = columnPin;
+}
+inline void hostReleaseKey() { hostHoldKey(0, 0); }
+
+inline void pinMode(uint8_t, uint8_t) { hostAdvance(hostCosts().pinUs); }
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+  hostPinLevels()[pin] = value;
+  hostAdvance(hostCosts().pinUs);
+}
+inline int digitalRead(uint8_t pin) {
+  hostAdvance(hostCosts().pinUs);
+  const uint8_t *held = hostHeldKey();
+  if (held[0] != 0 && pin == held[0] && hostPinLevels()[held[1]] == LOW) return LOW;
+  return HIGH;
+}
+
+// Last value and time of each pin's analogWrite()
+struct HostAnalog {
+  uint8_t value[80];
+  unsigned long at[80];
+  unsigned long writes;
+};
+inline HostAnalog &hostAnalog() {
+  static HostAnalog analog;
+  return analog;
+}
+inline void analogWrite(uint8_t pin, int value) {
+  hostAdvance(hostCosts().analogWriteUs);
+  hostAnalog().value[pin] = value;
+  hostAnalog().at[pin] = micros();
+  hostAnalog().writes++;
+}
+
+inline long random(long howBig) { return howBig > 0 ? ::random() % howBig : 0; }
+
+// Serial keeps what was sent, and takes input from received
+class HardwareSerial {
+public:
+  std::string sent;
+  std::string received;
+  bool begun = false;
+  unsigned long begunAt = 0;
+
+  void begin(unsigned long) {
+    begun = true;
+    begunAt = micros();
+  }
+  int available() { return received.size(); }
+  int read() {
+    if (received.empty()) return -1;
+    char ch = received[0];
+    received.erase(0, 1);
+    return ch;
+  }
+  size_t write(uint8_t ch) {
+    sent += (char)ch;
+    return 1;
+  }
+
+  size_t print(const char *text) {
+    sent += text;
+    return strlen(text);
+  }
+  size_t print(const __FlashStringHelper *text) { return print((const char *)text); }
+  size_t print(char ch) { return write(ch); }
+  size_t print(long value, int base = DEC) {
+    return value < 0 && base == DEC ? print('-') + print((unsigned long)-value, base)
+                                    : print((unsigned long)value, base);
+  }
+  size_t print(unsigned long value, int base = DEC) {
+    char text[24];
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+    return print(text);
+  }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(short value, int base = DEC) { return print((long)value, base); }
+  size_t println() { return print("\r\n"); }
+  template <typename T> size_t println(T value) { return print(value) + println(); }
+  template <typename T> size_t println(T value, int base) { return print(value, base) + println(); }
+};
+
+inline HardwareSerial &hostSerial() {
+  static HardwareSerial serial;
+  return serial;
+}
+#define Serial hostSerial()
+
+#endif
@@ -0,0 +1,33 @@
+// The Mega's 4 KB of EEPROM on the host, erased (0xFF) until written.
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+class EEPROMClass {
+public:
+  uint8_t data[4096];
+
+  EEPROMClass() { memset(data, 0xFF, sizeof(data)); }
+  uint8_t read(int address) { return data[address]; }
+  void write(int address, uint8_t value) { data[address] = value; }
+  void update(int address, uint8_t value) { data[address] = value; }
+  uint16_t length() { return sizeof(data); }
+  template <typename T> T &get(int address, T &value) {
+    memcpy(&value, data + address, sizeof(T));
+    return value;
+  }
+  template <typename T> const T &put(int address, const T &value) {
+    memcpy(data + address, &value, sizeof(T));
+    return value;
+  }
+};
+
+inline EEPROMClass &hostEEPROM() {
+  static EEPROMClass eeprom;
+  return eeprom;
+}
+#define EEPROM hostEEPROM()
+
+#endif
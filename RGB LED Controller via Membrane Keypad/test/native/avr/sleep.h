@@ -0,0 +1,33 @@
+// Idle sleep on the host: sleep_cpu() waits for the next Timer0 overflow,
+// the millis() tick every 1024 us, which is the only wake source the keypad
+// sketch has. hostSleep().idle = false makes it return at once instead, as
+// if the loop spun.
+#ifndef HOST_AVR_SLEEP_H
+#define HOST_AVR_SLEEP_H
+
+#include <Arduino.h>
+
+#define SLEEP_MODE_IDLE 0
+
+struct HostSleep {
+  bool idle = true;
+  bool enabled = false;
+  unsigned long sleeps = 0;
+};
+inline HostSleep &hostSleep() {
+  static HostSleep sleep;
+  return sleep;
+}
+
+static const unsigned long hostTickUs = 1024;
+
+inline void set_sleep_mode(uint8_t) {}
+inline void sleep_enable() { hostSleep().enabled = true; }
+inline void sleep_disable() { hostSleep().enabled = false; }
+inline void sleep_cpu() {
+  if (!hostSleep().enabled || !hostSleep().idle) return;
+  hostSleep().sleeps++;
+  hostAdvance(hostTickUs - micros() % hostTickUs);
+}
+
+#endif
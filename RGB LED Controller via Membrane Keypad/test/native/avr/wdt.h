@@ -0,0 +1,17 @@
+// The watchdog on the host: it only remembers whether it is running.
+#ifndef HOST_AVR_WDT_H
+#define HOST_AVR_WDT_H
+
+#include <stdint.h>
+
+#define WDTO_2S 7
+
+inline bool &hostWatchdog() {
+  static bool enabled = false;
+  return enabled;
+}
+inline void wdt_enable(uint8_t) { hostWatchdog() = true; }
+inline void wdt_disable() { hostWatchdog() = false; }
+inline void wdt_reset() {}
+
+#endif
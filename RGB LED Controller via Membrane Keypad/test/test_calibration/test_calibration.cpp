@@ -0,0 +1,183 @@
+// Colour calibration through main.cpp's serial commands: what each "cal"
+// line does to the tables, against the curve worked out in double; saving
+// to EEPROM and loading it back, or not when the save was cut short; the
+// longest command fitting the line buffer and a longer one dropped; and the
+// invalid-input flash going through the same output stage.
+#include <unity.h>
+#include "../../src/main.cpp"
+
+static void command(const char *line) {
+  Serial.received += line;
+  Serial.received += '\n';
+  loop();
+}
+
+// Every table entry against gain * 256 * (v / 255) ^ (10 / gamma), to the
+// rounding of the float curve
+static void expectCurve(uint8_t channel, uint8_t gain, uint8_t gamma) {
+  for (int value = 0; value < 256; value++) {
+    double level = pow(value / 255.0, 10.0 / gamma) * gain * 256;
+    TEST_ASSERT_INT_WITHIN(1, (int)(level + 0.5), calibrationLUT[channel][value]);
+  }
+}
+
+void setUp(void) {
+  static bool booted = false;
+  if (!booted) {
+    setup();
+    booted = true;
+  }
+  memset(EEPROM.data, 0xFF, sizeof(EEPROM.data));
+  command("cal reset");
+  Serial.sent.clear();
+}
+
+void tearDown(void) {}
+
+void test_default_is_linear(void) {
+  for (uint8_t channel = 0; channel < 3; channel++) expectCurve(channel, 255, 10);
+  TEST_ASSERT_FALSE(calibration.useMatrix);
+  writeLEDs(128, 37, 200);
+  TEST_ASSERT_EQUAL_UINT8(128, hostAnalog().value[redTLED]);
+  TEST_ASSERT_EQUAL_UINT8(37, hostAnalog().value[greenTLED]);
+  TEST_ASSERT_EQUAL_UINT8(200, hostAnalog().value[blueTLED]);
+}
+
+void test_gain_and_gamma(void) {
+  command("cal gain 128 255 64");
+  command("cal gamma 22 10 30");
+  TEST_ASSERT_EQUAL_UINT16(128 * 256, calibrationLUT[0][255]);
+  TEST_ASSERT_EQUAL_UINT16(255 * 256, calibrationLUT[1][255]);
+  TEST_ASSERT_EQUAL_UINT16(64 * 256, calibrationLUT[2][255]);
+  expectCurve(0, 128, 22);
+  expectCurve(1, 255, 10);
+  expectCurve(2, 64, 30);
+  // Each change prints the calibration
+  TEST_ASSERT_NOT_NULL(strstr(Serial.sent.c_str(), "Gain: 128 255 64 | Gamma x10: 22 10 30 | Matrix: off"));
+
+  // Out of range values are clamped, short ones ignored
+  command("cal gain 300 -5 255");
+  command("cal gamma 0 99 10");
+  command("cal gamma 12 12");
+  TEST_ASSERT_EQUAL_UINT8(255, calibration.gain[0]);
+  TEST_ASSERT_EQUAL_UINT8(0, calibration.gain[1]);
+  TEST_ASSERT_EQUAL_UINT8(1, calibration.gamma[0]);
+  TEST_ASSERT_EQUAL_UINT8(50, calibration.gamma[1]);
+  TEST_ASSERT_EQUAL_UINT8(10, calibration.gamma[2]);
+  TEST_ASSERT_EQUAL_UINT16(0, calibrationLUT[1][255]);
+  TEST_ASSERT_NOT_NULL(strstr(Serial.sent.c_str(), "Usage: cal"));
+}
+
+// A matrix that swaps red and green, then turned off again
+void test_matrix(void) {
+  command("cal matrix 0 256 0 256 0 0 0 0 256");
+  TEST_ASSERT_TRUE(calibration.useMatrix);
+  writeLEDs(200, 0, 90);
+  TEST_ASSERT_EQUAL_UINT8(0, hostAnalog().value[redTLED]);
+  TEST_ASSERT_EQUAL_UINT8(200, hostAnalog().value[greenTLED]);
+  TEST_ASSERT_EQUAL_UINT8(90, hostAnalog().value[blueTLED]);
+  // Mixing clamps to full scale
+  command("cal matrix 256 256 0 0 256 0 0 0 256");
+  writeLEDs(200, 200, 0);
+  TEST_ASSERT_EQUAL_UINT8(255, hostAnalog().value[redTLED]);
+
+  command("cal matrix off");
+  TEST_ASSERT_FALSE(calibration.useMatrix);
+  writeLEDs(200, 0, 90);
+  TEST_ASSERT_EQUAL_UINT8(200, hostAnalog().value[redTLED]);
+}
+
+// "cal matrix" and nine "-1024" fill the line buffer exactly; one more
+// character and the line is dropped whole, and the next one still works
+void test_longest_line(void) {
+  const char *longest = "cal matrix -1024 -1024 -1024 -1024 -1024 -1024 -1024 -1024 -1024";
+  TEST_ASSERT_EQUAL(64, strlen(longest));
+  command(longest);
+  TEST_ASSERT_TRUE(calibration.useMatrix);
+  for (uint8_t i = 0; i < 9; i++) TEST_ASSERT_EQUAL_INT16(-1024, calibration.matrix[i / 3][i % 3]);
+
+  command("cal matrix off");
+  Serial.sent.clear();
+  command("cal matrix -1024 -1024 -1024 -1024 -1024 -1024 -1024 -1024  -1024");
+  TEST_ASSERT_FALSE(calibration.useMatrix);
+  TEST_ASSERT_EQUAL_STRING("Line too long\r\n", Serial.sent.c_str());
+  command("cal gain 10 20 30");
+  TEST_ASSERT_EQUAL_UINT8(30, calibration.gain[2]);
+}
+
+// A saved calibration is what the next boot loads; an erased EEPROM, a
+// different magic or a save cut short load the defaults
+void test_save_and_reload(void) {
+  loadCalibration();
+  TEST_ASSERT_EQUAL_UINT16(CALIBRATION_MAGIC, calibration.magic);
+  TEST_ASSERT_EQUAL_UINT8(10, calibration.gamma[0]);
+
+  command("cal gain 200 150 100");
+  command("cal gamma 18 22 26");
+  command("cal matrix 230 26 0 0 256 0 13 0 243");
+  command("cal save");
+  TEST_ASSERT_NOT_NULL(strstr(Serial.sent.c_str(), "Calibration saved"));
+  Calibration saved = calibration;
+  uint16_t entry = calibrationLUT[2][77];
+  command("cal reset");
+  TEST_ASSERT_EQUAL_UINT8(255, calibration.gain[0]);
+
+  loadCalibration();
+  buildCalibrationLUTs();
+  TEST_ASSERT_EQUAL_MEMORY(&saved, &calibration, offsetof(Calibration, checksum));
+  TEST_ASSERT_EQUAL_UINT16(entry, calibrationLUT[2][77]);
+
+  // The gain of green half rewritten when the power went
+  EEPROM.data[CALIBRATION_ADDRESS + offsetof(Calibration, gain) + 1] = 0x96 ^ 0x0F;
+  loadCalibration();
+  TEST_ASSERT_EQUAL_UINT8(255, calibration.gain[1]);
+  TEST_ASSERT_EQUAL_UINT8(10, calibration.gamma[0]);
+
+  command("cal save");
+  EEPROM.data[CALIBRATION_ADDRESS] ^= 0x01;
+  loadCalibration();
+  TEST_ASSERT_EQUAL_UINT8(255, calibration.gain[0]);
+}
+
+// An invalid key flashes red three times through the calibrated output
+// stage, then the shown colour is back; the saved colour never changes
+void test_error_flash(void) {
+  command("cal gain 128 255 255");
+  enterMenu(MENU_MAIN);
+  writeLEDs(255, 255, 255);
+  uint8_t shown[3] = {savedState.shown[0], savedState.shown[1], savedState.shown[2]};
+
+  hostHoldKey(rowPins[0], colPins[0]);  // '1', which the main menu doesn't use
+  uint8_t states[8][3];
+  uint8_t count = 0;
+  uint8_t last[3] = {hostAnalog().value[redTLED], hostAnalog().value[greenTLED],
+                     hostAnalog().value[blueTLED]};
+  unsigned long start = millis();
+  while (millis() - start < 2000) {
+    loop();
+    if (millis() - start > 100) hostReleaseKey();
+    uint8_t now[3] = {hostAnalog().value[redTLED], hostAnalog().value[greenTLED],
+                      hostAnalog().value[blueTLED]};
+    if (memcmp(now, last, 3) != 0 && count < 8) memcpy(states[count++], now, 3);
+    memcpy(last, now, 3);
+    TEST_ASSERT_EQUAL_MEMORY(shown, savedState.shown, 3);
+  }
+
+  TEST_ASSERT_NOT_NULL(strstr(Serial.sent.c_str(), "Invalid Input"));
+  static const uint8_t expected[6][3] = {
+    {128, 0, 0}, {0, 0, 0}, {128, 0, 0}, {0, 0, 0}, {128, 0, 0}, {128, 255, 255},
+  };
+  TEST_ASSERT_EQUAL_UINT8(6, count);
+  TEST_ASSERT_EQUAL_MEMORY(expected, states, sizeof(expected));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_default_is_linear);
+  RUN_TEST(test_gain_and_gamma);
+  RUN_TEST(test_matrix);
+  RUN_TEST(test_longest_line);
+  RUN_TEST(test_save_and_reload);
+  RUN_TEST(test_error_flash);
+  return UNITY_END();
+}
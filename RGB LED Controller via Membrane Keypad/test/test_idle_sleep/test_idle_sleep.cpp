@@ -0,0 +1,153 @@
+// main.cpp on the host, idling between Timer0 ticks: sleep_cpu() waits for
+// the next 1024 us tick. In each mode the CPU must be asleep most of the
+// time, no sleep may outlast a tick, and a keypress must get through no more
+// than a tick later than with the loop spinning.
+//
+// The time charged is a rough AVR cost model: 4 us per pin access, 6 us per
+// analogWrite() and 30 us of overhead a pass through loop().
+#include <unity.h>
+#include "../../src/main.cpp"
+
+static const unsigned long passUs = 30;
+
+static uint32_t seed;
+
+static uint32_t nextRandom() {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+static void runFor(unsigned long ms) {
+  unsigned long start = micros();
+  while (micros() - start < ms * 1000) {
+    loop();
+    hostAdvance(passUs);
+  }
+}
+
+// Holds a key down on the matrix, by its place in the sketch's keymap
+static void holdKey(char key) {
+  for (byte r = 0; r < ROWS; r++) {
+    for (byte c = 0; c < COLS; c++) {
+      if (hexaKeys[r][c] == key) hostHoldKey(rowPins[r], colPins[c]);
+    }
+  }
+}
+
+static void press(char key) {
+  holdKey(key);
+  runFor(100);
+  hostReleaseKey();
+  runFor(100);
+}
+
+struct Window {
+  unsigned asleepPercent;
+  unsigned long longest;
+};
+
+// Runs a mode for a minute with fresh counters
+static Window measure() {
+  sleepMicros = awakeMicros = sleepCount = longestSleep = 0;
+  runFor(60000);
+  Window window = {(unsigned)(sleepMicros / ((sleepMicros + awakeMicros) / 100)), longestSleep};
+  return window;
+}
+
+void setUp(void) {
+  hostCosts().pinUs = 4;
+  hostCosts().analogWriteUs = 6;
+  hostSleep().idle = true;
+}
+
+void tearDown(void) {}
+
+void test_modes_sleep(void) {
+  setup();
+  TEST_ASSERT_EQUAL_UINT8(MENU_STANDBY, currentMenu);
+  Window standby = measure();
+  press('1');
+  press('A');
+  press('1');
+  TEST_ASSERT_EQUAL_UINT8(MENU_STATIC, currentMenu);
+  Window still = measure();
+  press('B');
+  press('C');
+  TEST_ASSERT_EQUAL_UINT8(MENU_CYCLE, currentMenu);
+  Window cycle = measure();
+
+  // The counters as # from the main menu reports them
+  press('D');
+  press('*');
+  TEST_ASSERT_EQUAL_UINT8(MENU_MAIN, currentMenu);
+  Serial.sent.clear();
+  unsigned long reportSleeps = sleepCount;
+  press('#');
+  unsigned percent, sleeps;
+  TEST_ASSERT_EQUAL(2, sscanf(Serial.sent.c_str(), "Power Stats\r\nAsleep: %u%% | Sleeps: %u",
+                              &percent, &sleeps));
+  TEST_ASSERT_GREATER_OR_EQUAL(reportSleeps, sleeps);
+  TEST_ASSERT_GREATER_OR_EQUAL(90, percent);
+
+  char message[120];
+  snprintf(message, sizeof(message),
+           "asleep: standby %u %%, static %u %%, cycle %u %%; longest sleep %lu/%lu/%lu us",
+           standby.asleepPercent, still.asleepPercent, cycle.asleepPercent,
+           standby.longest, still.longest, cycle.longest);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_GREATER_OR_EQUAL(90, standby.asleepPercent);
+  TEST_ASSERT_GREATER_OR_EQUAL(90, still.asleepPercent);
+  TEST_ASSERT_GREATER_OR_EQUAL(90, cycle.asleepPercent);
+  TEST_ASSERT_LESS_OR_EQUAL(hostTickUs, standby.longest);
+  TEST_ASSERT_LESS_OR_EQUAL(hostTickUs, still.longest);
+  TEST_ASSERT_LESS_OR_EQUAL(hostTickUs, cycle.longest);
+}
+
+// Worst time from a key going down at a random moment to the static menu
+// acting on it, over 200 presses
+static unsigned long worstKeyLatency(bool idle) {
+  hostSleep().idle = idle;
+  seed = 26;
+  unsigned long worst = 0;
+  for (int n = 0; n < 200; n++) {
+    char key = n % 2 ? '1' : '2';
+    unsigned long at = micros() + nextRandom() % 20000;
+    while (micros() < at) {
+      loop();
+      hostAdvance(passUs);
+    }
+    holdKey(key);
+    unsigned long pressed = micros();
+    while ((key == '1' ? currentState.red : currentState.green) == false) {
+      loop();
+      hostAdvance(passUs);
+      TEST_ASSERT_LESS_THAN(100000, micros() - pressed);
+    }
+    unsigned long latency = micros() - pressed;
+    if (latency > worst) worst = latency;
+    hostReleaseKey();
+    runFor(50);
+  }
+  return worst;
+}
+
+void test_key_latency(void) {
+  TEST_ASSERT_EQUAL_UINT8(MENU_MAIN, currentMenu);
+  press('A');
+  TEST_ASSERT_EQUAL_UINT8(MENU_STATIC, currentMenu);
+  unsigned long spinning = worstKeyLatency(false);
+  unsigned long sleeping = worstKeyLatency(true);
+
+  char message[80];
+  snprintf(message, sizeof(message), "worst key latency: spinning %lu us, sleeping %lu us",
+           spinning, sleeping);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_OR_EQUAL(spinning + hostTickUs, sleeping);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_modes_sleep);
+  RUN_TEST(test_key_latency);
+  return UNITY_END();
+}
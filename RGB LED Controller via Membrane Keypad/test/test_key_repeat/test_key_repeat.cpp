@@ -0,0 +1,130 @@
+// Typematic repeat timing of the Keypad library, driven through a scripted
+// key matrix on a host clock that advances 1 ms per loop() pass.
+#include <Arduino.h>
+#include <Keypad.h>
+#include <unity.h>
+
+const byte ROWS = 4;
+const byte COLS = 4;
+char keys[ROWS][COLS] = {
+  {'1', '2', '3', 'A'},
+  {'4', '5', '6', 'B'},
+  {'7', '8', '9', 'C'},
+  {'*', '0', '#', 'D'},
+};
+byte matrixRows[ROWS] = {23, 25, 27, 29};
+byte matrixCols[COLS] = {31, 33, 35, 37};
+
+// A keypad whose pins read from a matrix the test holds keys down on
+class ScriptedKeypad : public Keypad {
+public:
+  ScriptedKeypad() : Keypad(makeKeymap(keys), matrixRows, matrixCols, ROWS, COLS) {}
+
+  int held = -1;       // Key code held down, or -1
+  byte column = 0xFF;  // Column being driven low
+
+  void pin_mode(byte, byte) override {}
+  void pin_write(byte pin, boolean level) override {
+    for (byte c = 0; c < COLS; c++) {
+      if (matrixCols[c] == pin) column = level == LOW ? c : 0xFF;
+    }
+  }
+  int pin_read(byte pin) override {
+    for (byte r = 0; r < ROWS; r++) {
+      if (matrixRows[r] == pin) return held == r * COLS + column ? LOW : HIGH;
+    }
+    return HIGH;
+  }
+};
+
+struct Report {
+  unsigned long atMs;
+  bool repeated;
+};
+
+// Holds key '5' for holdMs, one getKey() per millisecond, and records
+// every time it is reported
+static int pressAndHold(ScriptedKeypad &keypad, unsigned long holdMs,
+                        Report *reports, int max) {
+  int count = 0;
+  unsigned long start = millis();
+  keypad.held = 1 * COLS + 1;
+  for (unsigned long t = 0; t < holdMs + 100; t++) {
+    if (t == holdMs) keypad.held = -1;
+    char key = keypad.getKey();
+    if (key != NO_KEY) {
+      TEST_ASSERT_EQUAL_CHAR('5', key);
+      if (count < max) {
+        reports[count].atMs = millis() - start;
+        reports[count].repeated = keypad.keyRepeated();
+      }
+      count++;
+    }
+    hostAdvance(1000);
+  }
+  return count;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Without setRepeatRate() a held key is reported once, as before
+void test_repeat_off_by_default() {
+  ScriptedKeypad keypad;
+  Report reports[4];
+  TEST_ASSERT_EQUAL(1, pressAndHold(keypad, 3000, reports, 4));
+  TEST_ASSERT_FALSE(reports[0].repeated);
+}
+
+// The sketch's rate: after the 500 ms hold, 150 ms speeding up by 15 ms per
+// repeat to 30 ms. The keypad is scanned every 11 ms (debounce 10 ms, strict
+// compare), so each interval is its nominal value rounded up to a scan.
+void test_repeat_accelerates_to_minimum() {
+  ScriptedKeypad keypad;
+  keypad.setRepeatRate(150, 30, 15);
+  Report reports[64];
+  int count = pressAndHold(keypad, 3000, reports, 64);
+  TEST_ASSERT_GREATER_OR_EQUAL(20, count);
+
+  TEST_ASSERT_FALSE(reports[0].repeated);
+  for (int i = 1; i < count && i < 64; i++) TEST_ASSERT_TRUE(reports[i].repeated);
+
+  // First repeat: the hold time (500 ms, strict compare) from the press
+  TEST_ASSERT_INT_WITHIN(11, 506, reports[1].atMs - reports[0].atMs);
+
+  unsigned long nominal = 150;
+  unsigned long previous = 1000;
+  for (int i = 2; i < count && i < 64; i++) {
+    unsigned long interval = reports[i].atMs - reports[i - 1].atMs;
+    TEST_ASSERT_GREATER_OR_EQUAL(nominal, interval);
+    TEST_ASSERT_LESS_OR_EQUAL(nominal + 11, interval);
+    TEST_ASSERT_LESS_OR_EQUAL(previous, interval);
+    previous = interval;
+    nominal = nominal > 30 + 15 ? nominal - 15 : 30;
+  }
+  // Settled at the minimum, rounded up to a whole number of scans
+  TEST_ASSERT_EQUAL(33, reports[count - 1].atMs - reports[count - 2].atMs);
+}
+
+// Releasing the key stops the repeats, and the next press is fresh
+void test_release_stops_repeat() {
+  ScriptedKeypad keypad;
+  keypad.setRepeatRate(150, 30, 15);
+  Report reports[64];
+  int held = pressAndHold(keypad, 1000, reports, 64);
+  // Press at ~11 ms, hold at ~517 ms, then repeats 150, 135, 120 ... ms
+  TEST_ASSERT_EQUAL(5, held);
+  TEST_ASSERT_LESS_OR_EQUAL(1000, reports[held - 1].atMs);
+
+  int again = pressAndHold(keypad, 200, reports, 64);
+  TEST_ASSERT_EQUAL(1, again);
+  TEST_ASSERT_FALSE(reports[0].repeated);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_repeat_off_by_default);
+  RUN_TEST(test_repeat_accelerates_to_minimum);
+  RUN_TEST(test_release_stops_repeat);
+  return UNITY_END();
+}
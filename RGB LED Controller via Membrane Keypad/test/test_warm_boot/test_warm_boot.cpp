@@ -0,0 +1,195 @@
+// main.cpp on the host through resets: reset() puts every variable back the
+// way the C runtime would, except the .noinit ones, and leaves the flags
+// captureResetFlags() would have found. A watchdog or brown-out reset must
+// relight the LED as it was before anything slow in setup(); a power-on
+// reset, or state that fails its checks, must come up in standby.
+//
+// The time charged is a rough AVR cost model: 4 us per pin access, 6 us per
+// analogWrite(), 30 us of overhead a pass through loop() and 300 us per
+// pow(), which the relight calls once a channel before the tables exist.
+#include <unity.h>
+#include <Arduino.h>
+
+static const unsigned long powUs = 300;
+static unsigned long powsUnlit;  // Calls made before the LED was lit
+
+static float hostPow(float base, float exponent) {
+  if (hostAnalog().writes < 3) powsUnlit++;
+  hostAdvance(powUs);
+  return powf(base, exponent);
+}
+#define pow hostPow
+
+#include "../../src/main.cpp"
+
+static const unsigned long passUs = 30;
+
+static void runFor(unsigned long ms) {
+  unsigned long start = micros();
+  while (micros() - start < ms * 1000) {
+    loop();
+    hostAdvance(passUs);
+  }
+}
+
+static void press(char key) {
+  for (byte r = 0; r < ROWS; r++) {
+    for (byte c = 0; c < COLS; c++) {
+      if (hexaKeys[r][c] == key) hostHoldKey(rowPins[r], colPins[c]);
+    }
+  }
+  runFor(100);
+  hostReleaseKey();
+  runFor(100);
+}
+
+static void reset(uint8_t flags) {
+  redVal = greenVal = blueVal = 255;
+  currentState = {false, false, false};
+  currentMenu = MENU_MAIN;
+  modeMillis = 0;
+  cycleInterval = 100;
+  cycleHue = 0;
+  memset(&calibration, 0, sizeof(calibration));
+  memset(calibrationLUT, 0, sizeof(calibrationLUT));
+  calibrationReady = false;
+  Serial = HardwareSerial();
+  memset(&hostAnalog(), 0, sizeof(HostAnalog));
+  hostWatchdog() = false;
+  resetFlags = flags;
+}
+
+struct Boot {
+  unsigned long litUs;     // setup() start to the last of the three LED writes
+  unsigned long serialUs;  // setup() start to Serial.begin()
+  uint8_t menu;
+};
+
+static Boot boot(uint8_t flags) {
+  reset(flags);
+  powsUnlit = 0;
+  unsigned long start = micros();
+  setup();
+  unsigned long lit = max(max(hostAnalog().at[redTLED], hostAnalog().at[greenTLED]),
+                          hostAnalog().at[blueTLED]);
+  Boot result = {lit - start, Serial.begunAt - start, currentMenu};
+  return result;
+}
+
+static void expectShown(const uint8_t *levels) {
+  TEST_ASSERT_EQUAL_UINT8(levels[0], hostAnalog().value[redTLED]);
+  TEST_ASSERT_EQUAL_UINT8(levels[1], hostAnalog().value[greenTLED]);
+  TEST_ASSERT_EQUAL_UINT8(levels[2], hostAnalog().value[blueTLED]);
+}
+
+void setUp(void) {
+  hostCosts().pinUs = 4;
+  hostCosts().analogWriteUs = 6;
+  memset(&savedState, 0xA5, sizeof(savedState));  // What SRAM powers up with
+}
+
+void tearDown(void) {}
+
+// A static colour at reduced brightness comes back after a watchdog reset,
+// lit before Serial.begin() and the table build
+void test_watchdog_reset_relights(void) {
+  Boot cold = boot(_BV(PORF));
+  TEST_ASSERT_EQUAL_UINT8(MENU_STANDBY, cold.menu);
+  press('1');
+  press('A');
+  press('6');
+  press('0');
+  press('2');
+  press('2');
+  press('3');
+  TEST_ASSERT_EQUAL_UINT8(MENU_STATIC, currentMenu);
+  uint8_t shown[3] = {hostAnalog().value[redTLED], hostAnalog().value[greenTLED],
+                      hostAnalog().value[blueTLED]};
+  TEST_ASSERT_EQUAL_UINT8(0, shown[1]);
+  TEST_ASSERT_TRUE(shown[0] > 0 && shown[0] < 255);
+
+  Boot warm = boot(_BV(WDRF));
+  char message[120];
+  snprintf(message, sizeof(message),
+           "warm boot: lit %lu us into setup() after %lu pow(), Serial.begin() at %lu us",
+           warm.litUs, powsUnlit, warm.serialUs);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL_UINT8(MENU_STATIC, warm.menu);
+  expectShown(shown);
+  TEST_ASSERT_EQUAL_UINT32(3, hostAnalog().writes);
+  TEST_ASSERT_EQUAL_UINT32(3, powsUnlit);
+  TEST_ASSERT_LESS_OR_EQUAL(1000, warm.litUs);
+  TEST_ASSERT_LESS_THAN(warm.serialUs, warm.litUs);
+  TEST_ASSERT_TRUE(hostWatchdog());
+
+  // Still the same colour, and still dimmed: brightness works from it
+  press('0');
+  press('1');
+  TEST_ASSERT_EQUAL_UINT8(0, hostAnalog().value[greenTLED]);
+  TEST_ASSERT_GREATER_THAN(shown[0], hostAnalog().value[redTLED]);
+}
+
+// The colour cycle resumes at the hue it had reached, at its speed
+void test_brown_out_resumes_cycle(void) {
+  boot(_BV(PORF));
+  press('1');
+  press('C');
+  press('5');
+  runFor(3000);
+  TEST_ASSERT_EQUAL_UINT8(MENU_CYCLE, currentMenu);
+  float hue = cycleHue;
+  uint8_t shown[3] = {hostAnalog().value[redTLED], hostAnalog().value[greenTLED],
+                      hostAnalog().value[blueTLED]};
+
+  Boot warm = boot(_BV(BORF));
+  TEST_ASSERT_EQUAL_UINT8(MENU_CYCLE, warm.menu);
+  expectShown(shown);
+  TEST_ASSERT_EQUAL_FLOAT(hue, cycleHue);
+  TEST_ASSERT_EQUAL_UINT32(125, cycleInterval);
+  TEST_ASSERT_LESS_OR_EQUAL(1000, warm.litUs);
+  runFor(1000);
+  TEST_ASSERT_FLOAT_WITHIN(5.0f, hue + 4.0f, cycleHue);
+}
+
+// Power-on, and state that fails its magic, checksum or menu check, play
+// standby from dark; the stock bootloader's 0 flags rely on those checks
+void test_cold_starts_standby(void) {
+  boot(_BV(PORF));
+  press('1');
+  press('A');
+  press('7');
+  TEST_ASSERT_EQUAL_UINT8(MENU_STATIC, currentMenu);
+  SavedState good = savedState;
+  static const uint8_t dark[3] = {0, 0, 0};
+
+  TEST_ASSERT_EQUAL_UINT8(MENU_STANDBY, boot(_BV(PORF) | _BV(EXTRF)).menu);
+  expectShown(dark);
+
+  savedState = good;
+  savedState.shown[0] ^= 0x10;
+  TEST_ASSERT_EQUAL_UINT8(MENU_STANDBY, boot(_BV(WDRF)).menu);
+  expectShown(dark);
+
+  savedState = good;
+  savedState.magic++;
+  savedState.checksum = savedStateChecksum();
+  TEST_ASSERT_EQUAL_UINT8(MENU_STANDBY, boot(_BV(WDRF)).menu);
+
+  savedState = good;
+  savedState.menu = MENU_COUNT;
+  savedState.checksum = savedStateChecksum();
+  TEST_ASSERT_EQUAL_UINT8(MENU_STANDBY, boot(_BV(WDRF)).menu);
+
+  savedState = good;
+  TEST_ASSERT_EQUAL_UINT8(MENU_STATIC, boot(0).menu);
+  static const uint8_t white[3] = {255, 255, 255};
+  expectShown(white);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_watchdog_reset_relights);
+  RUN_TEST(test_brown_out_resumes_cycle);
+  RUN_TEST(test_cold_starts_standby);
+  return UNITY_END();
+}
@@ -0,0 +1,41 @@
+// Timer-driven alert patterns for the Mood Light buzzer and red LED.
+//
+// A pattern is a burst of on/off pulses, repeated a number of times and
+// followed by a pause, with the whole cycle played a number of times (or
+// forever). Patterns live in PROGMEM and are played from the Timer5 compare
+// interrupts, one compare unit per channel, so their timing is exact to the
+// 4 us timer tick and independent of how busy loop() is. Each channel plays
+// one pattern at a time; a new pattern replaces the current one only if its
+// priority is at least as high.
+//
+// Timer5 is taken over, so analogWrite() on pins 44-46 is not available.
+#ifndef ALERT_PATTERNS_H
+#define ALERT_PATTERNS_H
+
+#include <stdint.h>
+
+struct AlertPattern {
+  uint16_t onMs;    // Pulse length (must be > 0)
+  uint16_t offMs;   // Gap after each pulse
+  uint8_t repeats;  // Pulses per burst
+  uint16_t pauseMs; // Extra gap after each burst
+  uint8_t cycles;   // Bursts to play, 0 = until cancelled
+};
+
+enum AlertChannel : uint8_t { ALERT_BUZZER, ALERT_LED, ALERT_CHANNELS };
+
+// Called from the timer interrupt to switch a channel's output
+typedef void (*AlertOutput)(bool on);
+
+void alertBegin(AlertOutput buzzer, AlertOutput led);
+
+// Start pattern (a PROGMEM address) on a channel. Returns false if the
+// channel is busy with a higher-priority pattern.
+bool alertPlay(uint8_t channel, const AlertPattern *pattern, uint8_t priority);
+
+// Stop the channel if its pattern's priority is at most priority.
+void alertCancel(uint8_t channel, uint8_t priority);
+
+bool alertPlaying(uint8_t channel);
+
+#endif
@@ -0,0 +1,29 @@
+// Temperature-to-colour gradient for the Mood Light.
+//
+// A piecewise-linear colour ramp (blue -> cyan -> green -> yellow -> red) is
+// stored in PROGMEM and stretched over a configurable temperature range.
+// gradientTarget() maps a temperature to a colour with one table lookup and a
+// few multiplies; gradientStep() eases the shown colour toward that target so
+// the LED fades rather than jumps. Temperatures are in tenths of a degree C.
+#ifndef COLOR_GRADIENT_H
+#define COLOR_GRADIENT_H
+
+#include <stdint.h>
+
+struct RGB {
+  uint8_t r, g, b;
+};
+
+// Set the temperatures shown as the first and last colour of the ramp.
+// Returns false (and keeps the old range) unless cold < hot.
+bool gradientSetRange(int16_t coldC, int16_t hotC);
+int16_t gradientColdC();
+int16_t gradientHotC();
+
+RGB gradientTarget(int16_t tempC);
+
+// Move shown one step (1/8 of the way) toward target; returns false once
+// they match.
+bool gradientStep(RGB &shown, const RGB &target);
+
+#endif
@@ -0,0 +1,59 @@
+// Reading history for the Mood Light, kept in SRAM.
+//
+// The history is historyBlocks blocks of historyBlockBytes. A block starts
+// from one reading stored whole, in its header. Each reading after it is
+// stored as the change from the one before, zig-zag coded so small changes in
+// either direction are small numbers:
+//   - both changes in -7..+7: one byte, temperature in the high nibble and
+//     humidity in the low nibble
+//   - otherwise 0xF0, then each change as a varint (7 bits a byte)
+//   - 0xF1 and a varint n: n readings were missed before the next one
+// No time is stored per reading: a block keeps the times of its first and
+// last readings, and the readings in between are taken as evenly spaced
+// (missed ones counted in sensor periods). When the blocks are full, the
+// oldest one is dropped whole.
+//
+// Each block header also keeps a running min / max / sum, so summaries never
+// need to decode the history. At 2 s a reading, a block covers about 7
+// minutes and the whole history about 2 hours.
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+
+const uint8_t historyBlocks = 16;
+const uint8_t historyBlockBytes = 224;
+
+struct HistorySummary {
+  uint16_t samples;
+  uint32_t fromAt;  // millis() of the first reading covered
+  int16_t minTemp, maxTemp, meanTemp; // 0.1 °C
+  int16_t minHumidity, maxHumidity, meanHumidity; // 0.1 %
+};
+
+// Reading position for streaming the history out, oldest reading first.
+// A reader that falls behind the oldest block carries on from there.
+struct HistoryCursor {
+  uint16_t block;   // Block sequence number
+  uint8_t offset;   // Next data byte in the block
+  uint16_t step;    // Periods since the block's first reading
+  bool started;     // The block's header reading has been returned
+  int16_t temp, humidity;
+};
+
+void historyBegin(uint16_t periodMs);
+void historyAdd(uint32_t takenAt, int16_t temp, int16_t humidity);
+
+uint16_t historySamples();
+uint16_t historyBytesUsed();
+
+// Summary of the blocks holding readings from the last windowMs before now
+// (whole blocks, so it can reach up to one block further back). False if
+// there are none.
+bool historySummary(uint32_t now, uint32_t windowMs, HistorySummary *summary);
+
+void historyRewind(HistoryCursor &cursor);
+// Next reading, or false if the cursor has caught up with the newest one
+bool historyNext(HistoryCursor &cursor, uint32_t *at, int16_t *temp, int16_t *humidity);
+
+#endif
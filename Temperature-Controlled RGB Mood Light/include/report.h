@@ -0,0 +1,61 @@
+// Serial reporting for the Mood Light.
+//
+// Readings are formatted straight from their tenths into a line buffer (no
+// floats, no Serial.print per field) and queued on a TX ring. loop() drains
+// the ring only as far as the UART buffer has room, so reporting never waits
+// on the 9600 baud line. Other messages go through the same ring by printing
+// to reportOut, a line at a time, so they can't land in the middle of a record
+// and are never cut short.
+//
+// Record formats:
+//   text    Humidity: 72.3% | Temperatures: 23.9C, 75.0F, ... (default)
+//   csv     ms,tempC,humidity,heatIndexC  e.g. "123456,23.9,72.3,24.2"
+//   binary  11 bytes: 0xA5, sequence, millis (4), tempC (2), humidity (2),
+//           XOR of the bytes after 0xA5. Multi-byte fields are little-endian
+//           tenths. A host reader resyncs on 0xA5 and the checksum, since
+//           command replies and error messages are still sent as text.
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <Arduino.h>
+
+enum ReportFormat : uint8_t { REPORT_TEXT, REPORT_CSV, REPORT_BINARY };
+
+struct ReportSample {
+  uint32_t takenAt;    // millis() of the reading
+  int16_t tempC;       // 0.1 °C
+  int16_t humidity;    // 0.1 %
+  int16_t tempF;       // 0.1 °F
+  int16_t heatIndexC;  // 0.1 °C
+  int16_t heatIndexF;  // 0.1 °F
+  uint32_t maxLoopUs;  // Longest loop() pass so far
+};
+
+// Print onto the TX ring. Text collects until the end of the line, which is
+// then queued whole, or dropped whole and counted like a record if the ring
+// has no room (or the line is over 159 bytes).
+class ReportOut : public Print {
+public:
+  size_t write(uint8_t ch) override;
+  using Print::write;
+};
+
+extern ReportOut reportOut;
+
+void reportSetFormat(ReportFormat format);
+ReportFormat reportFormat();
+const __FlashStringHelper *reportFormatName(ReportFormat format);
+
+// Format and queue one reading. A record is queued whole or not at all;
+// returns false (and counts a drop) when the ring has no room for it.
+bool reportSample(const ReportSample &sample);
+
+// Move queued bytes to Serial without blocking. Call from every loop().
+void reportPump();
+
+// Free space on the TX ring (bytes)
+uint8_t reportRoom();
+
+uint16_t reportDropped();
+
+#endif
@@ -0,0 +1,37 @@
+// Temperature smoothing and band tracking for the Mood Light.
+//
+// Each reading goes through a running median (to drop single-sample spikes)
+// and then an exponential moving average. The smoothed value is sorted into
+// cold / comfortable / hot bands with hysteresis, so a temperature hovering
+// at a threshold doesn't make the LED and alert flap. All values are in
+// tenths of a degree Celsius.
+#ifndef TEMP_FILTER_H
+#define TEMP_FILTER_H
+
+#include <stdint.h>
+
+const uint8_t filterWindow = 5; // Median window (samples, odd)
+const uint8_t filterShift = 2;  // EMA weight of a new sample: 1 / 2^filterShift
+
+struct TempFilter {
+  int16_t ring[filterWindow]; // Last samples, oldest overwritten first
+  uint8_t head;
+  uint8_t count;
+  int32_t ema;                // Average, scaled by 16
+};
+
+enum TempBand : uint8_t { BAND_COLD, BAND_COMFORT, BAND_HOT, BAND_UNKNOWN };
+
+struct BandConfig {
+  int16_t comfortFrom; // Below this is cold
+  int16_t hotFrom;     // From this up is hot
+  int16_t hysteresis;  // How far past a threshold before the band changes
+};
+
+void filterReset(TempFilter &filter);
+int16_t filterAdd(TempFilter &filter, int16_t sample);
+
+// Returns true when the band changed; *band holds the current band.
+bool bandUpdate(TempBand *band, const BandConfig &config, int16_t temp);
+
+#endif
@@ -0,0 +1,39 @@
+// Rate-of-change tracking for the Mood Light.
+//
+// Keeps a least-squares line through the last trendWindow readings. The sums
+// behind it are updated as each reading enters and the oldest leaves, so an
+// update costs the same whatever the window size, and everything is integer.
+// From the line it projects how long until the temperature reaches a
+// threshold, which lets the sketch warn before the hot alert rather than
+// after. Temperatures are in tenths of a degree Celsius; time is counted in
+// readings and converted with the sensor's reading period.
+#ifndef TEMP_TREND_H
+#define TEMP_TREND_H
+
+#include <stdint.h>
+
+const uint8_t trendWindow = 32; // Readings in the fit (64 s at 2 s a reading)
+const uint32_t trendNever = 0xFFFFFFFF;
+
+struct TempTrend {
+  int16_t ring[trendWindow]; // Last readings, oldest overwritten first
+  uint8_t head;
+  uint8_t count;
+  int32_t sumY;              // Sum of the readings
+  int32_t sumXY;             // Sum of reading * position (0 = oldest)
+};
+
+void trendReset(TempTrend &trend);
+void trendAdd(TempTrend &trend, int16_t temp);
+
+// The fit is only used once the window is full
+bool trendReady(const TempTrend &trend);
+
+// Slope of the fit in 0.1 °C per minute
+int16_t trendPerMinute(const TempTrend &trend, uint16_t periodMs);
+
+// Time (ms) until the fitted line reaches threshold: 0 if it already has,
+// trendNever if it isn't heading there (or the window isn't full yet).
+uint32_t trendTimeTo(const TempTrend &trend, int16_t threshold, uint16_t periodMs);
+
+#endif
@@ -0,0 +1,152 @@
+/*
+ * Scheduler for several DHT sensors sharing one board.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "dht_bus.h"
+
+
+DHT_bus::DHT_bus( DHT_nonblocking *const *sensors, uint8_t count )
+{
+  if( count > DHT_BUS_MAX_SENSORS )
+  {
+    count = DHT_BUS_MAX_SENSORS;
+  }
+  _count = count;
+  _started = false;
+  _period = 0;
+  _readings = 0;
+  _longest_poll = 0;
+
+  for( uint8_t i = 0; i < count; ++i )
+  {
+    _sensors[ i ] = sensors[ i ];
+    if( sensors[ i ]->min_interval( ) > _period )
+    {
+      _period = sensors[ i ]->min_interval( );
+    }
+    _latest[ i ].temperature = NAN;
+    _latest[ i ].humidity = NAN;
+    _latest[ i ].timestamp = 0;
+    _latest[ i ].valid = false;
+  }
+  _period += DHT_BUS_MARGIN;
+}
+
+
+
+/*
+ * True if any sensor other than the given one is between the start of a
+ * measurement and its read window.
+ */
+bool DHT_bus::others_measuring( uint8_t index ) const
+{
+  for( uint8_t i = 0; i < _count; ++i )
+  {
+    if( i != index && _sensors[ i ]->is_measuring( ) == true )
+    {
+      return( true );
+    }
+  }
+  return( false );
+}
+
+
+
+/*
+ * Advance every sensor.  A sensor in the middle of a measurement or in its
+ * cooldown is always polled.  An idle sensor is started when its slot comes
+ * up, or straight away when it owes a quick retry, but never while another
+ * sensor is measuring.  Slots are period / count apart, so normally nobody
+ * has to wait.  Returns true if any sensor produced a new reading.
+ */
+bool DHT_bus::poll( )
+{
+  unsigned long now = millis( );
+  bool updated = false;
+
+  if( _started == false )
+  {
+    for( uint8_t i = 0; i < _count; ++i )
+    {
+      _next_start[ i ] = now + (unsigned long) i * _period / _count;
+    }
+    _started = true;
+  }
+
+  for( uint8_t i = 0; i < _count; ++i )
+  {
+    DHT_nonblocking *sensor = _sensors[ i ];
+    if( sensor->is_idle( ) == true )
+    {
+      bool slot = (long) ( now - _next_start[ i ] ) >= 0;
+      if( ( slot == false && sensor->retry_pending( ) == false )
+          || others_measuring( i ) == true )
+      {
+        continue;
+      }
+      if( slot == true )
+      {
+        /* Keep to the slot grid unless we have fallen a whole period
+           behind, in which case the slot is moved rather than started
+           twice. */
+        _next_start[ i ] += _period;
+        if( (long) ( now - _next_start[ i ] ) >= 0 )
+        {
+          _next_start[ i ] = now + _period;
+        }
+      }
+    }
+
+    unsigned long started = micros( );
+    float temperature, humidity;
+    bool done = sensor->measure( &temperature, &humidity );
+    unsigned long elapsed = micros( ) - started;
+    if( elapsed > _longest_poll )
+    {
+      _longest_poll = elapsed;
+    }
+
+    if( done == true )
+    {
+      _latest[ i ].temperature = temperature;
+      _latest[ i ].humidity = humidity;
+      _latest[ i ].timestamp = now;
+      _latest[ i ].valid = true;
+      ++_readings;
+      updated = true;
+    }
+    else if( sensor->is_idle( ) == false && _latest[ i ].timestamp != 0
+             && now - _latest[ i ].timestamp > 2UL * _period )
+    {
+      /* Two periods without a reading: the sensor has stopped answering. */
+      _latest[ i ].valid = false;
+    }
+  }
+
+  return( updated );
+}
+
+
+
+/*
+ * The most recent reading of a sensor.  Check valid before using the
+ * values, and timestamp (in millis( )) to see how old they are.
+ */
+const DHT_reading &DHT_bus::latest( uint8_t index ) const
+{
+  return( _latest[ index ] );
+}
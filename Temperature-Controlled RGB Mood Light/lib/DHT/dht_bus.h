@@ -0,0 +1,75 @@
+/*
+ * Scheduler for several DHT sensors sharing one board.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _DHT_BUS_H
+#define _DHT_BUS_H
+
+#include "dht_nonblocking.h"
+
+
+#define DHT_BUS_MAX_SENSORS  4
+
+/* The time between two reads of the same sensor is the longest minimum
+   interval of the sensors plus this margin, which covers the 250 ms
+   release, the start signal, and the frame. */
+#define DHT_BUS_MARGIN  300
+
+
+struct DHT_reading
+{
+  float temperature;
+  float humidity;
+  unsigned long timestamp;
+  bool valid;
+};
+
+
+/*
+ * Owns up to DHT_BUS_MAX_SENSORS sensors and starts them one slot apart
+ * so that their measurements, and so their timing-critical read windows,
+ * never overlap.  Call poll( )
+ * from loop( ) and pick up the latest reading of each sensor with latest( ).
+ */
+class DHT_bus
+{
+  public:
+    DHT_bus( DHT_nonblocking *const *sensors, uint8_t count );
+    bool poll( );
+    const DHT_reading &latest( uint8_t index ) const;
+
+    uint8_t count( ) const { return( _count ); }
+    uint32_t readings( ) const { return( _readings ); }
+    unsigned long longest_poll_us( ) const { return( _longest_poll ); }
+    uint16_t period( ) const { return( _period ); }
+
+  private:
+    bool others_measuring( uint8_t index ) const;
+
+    DHT_nonblocking *_sensors[ DHT_BUS_MAX_SENSORS ];
+    DHT_reading _latest[ DHT_BUS_MAX_SENSORS ];
+    unsigned long _next_start[ DHT_BUS_MAX_SENSORS ];
+    uint8_t _count;
+    uint16_t _period;
+    bool _started;
+
+    uint32_t _readings;
+    unsigned long _longest_poll;
+};
+
+
+#endif /* _DHT_BUS_H */
@@ -0,0 +1,171 @@
+/*
+ * Fixed-point heat index and dew point for the DHT non-blocking library.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "dht_nonblocking.h"
+
+
+/* log2( 1 + i / 16 ) in Q12, for i = 0 to 16. */
+static const uint16_t log2_table[ 17 ] PROGMEM =
+{
+     0,  358,  696, 1016, 1319, 1607, 1882, 2145, 2396,
+  2637, 2869, 3092, 3307, 3514, 3715, 3908, 4096
+};
+
+
+
+/* Integer square root, rounded down. */
+static uint16_t isqrt( uint32_t value )
+{
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+
+  while( bit > value )
+  {
+    bit >>= 2;
+  }
+  while( bit != 0 )
+  {
+    if( value >= root + bit )
+    {
+      value -= root + bit;
+      root = ( root >> 1 ) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return( root );
+}
+
+
+
+/* log2 of a value from 1 to 32767 in Q12, by table and linear interpolation. */
+static int32_t log2_q12( uint16_t value )
+{
+  uint8_t exponent = 15;
+  while( ( value & 0x8000 ) == 0 )
+  {
+    value <<= 1;
+    --exponent;
+  }
+
+  uint16_t fraction = value & 0x7fff;
+  uint8_t index = fraction >> 11;
+  uint16_t remainder = fraction & 0x07ff;
+  int32_t low  = pgm_read_word( &log2_table[ index ] );
+  int32_t high = pgm_read_word( &log2_table[ index + 1 ] );
+
+  return( ( (int32_t) exponent << 12 ) + low + ( ( ( high - low ) * remainder ) >> 11 ) );
+}
+
+
+
+/*
+ * Heat index by the same rules as Adafruit's computeHeatIndex( ): Steadman's
+ * simple formula, switching to the Rothfusz regression with its low and high
+ * humidity adjustments above 79 F.  The arithmetic is done in degrees
+ * Fahrenheit on 32-bit integers, with the temperature in fiftieths of a
+ * degree so that the conversion from tenths of a degree Celsius is exact.
+ */
+int16_t dht_heat_index( int16_t temperature, int16_t humidity )
+{
+  int32_t t = 9L * temperature + 1600;   /* 1/50 F */
+  int32_t r = humidity;                  /* 1/10 % */
+
+  /* Simple formula, 1.1 T - 10.3 + 0.047 R, in 1/10000 F. */
+  int32_t simple = 220L * t - 103000L + 47L * r;
+  int32_t hi;                            /* Q12 F */
+
+  if( simple <= 790000L )
+  {
+    hi = ( simple << 8 ) / 625;            /* 4096 / 10000 = 256 / 625 */
+  }
+  else
+  {
+    /* HI = A( T ) + R ( B( T ) + R C( T ) ), each a quadratic in T. */
+    int32_t c = 937685506L + -43761L * t;                  /* Q40 */
+    c = ( -7357436L + ( ( c >> 13 ) * t ) / 50 ) >> 5;    /* Q22 */
+
+    int32_t b = -965317136L + 105548L * t;                 /* Q32 */
+    b = 21272107L + ( ( b >> 11 ) * t ) / 50;              /* Q21 */
+
+    int32_t a = 137507084L + -9178L * t;                   /* Q26 */
+    a = -2777350L + ( ( a >> 10 ) * t ) / 50;              /* Q16 */
+
+    b += ( ( c * r ) / 10 ) >> 1;                          /* Q21 */
+    hi = ( a >> 4 ) + ( ( ( b >> 6 ) * r ) / 10 >> 3 );    /* Q12 */
+
+    if( r < 130 && t >= 4000 && t <= 5600 )
+    {
+      /* ( 13 - R ) / 4 * sqrt( ( 17 - | T - 95 | ) / 17 ) */
+      int32_t distance = t - 4750;
+      if( distance < 0 )
+      {
+        distance = -distance;
+      }
+      uint16_t root = isqrt( ( (uint32_t) ( 850 - distance ) << 20 ) / 850 );  /* Q10 */
+      hi -= ( ( 130 - r ) * root ) / 10;
+    }
+    else if( r > 850 && t >= 4000 && t <= 4350 )
+    {
+      /* ( R - 85 ) / 10 * ( 87 - T ) / 5 */
+      hi += ( ( r - 850 ) * ( 4350 - t ) * 4096L ) / 25000;
+    }
+  }
+
+  /* Back to tenths of a degree Celsius, rounded. */
+  int32_t celsius = ( hi - ( 32L << 12 ) ) * 50 / 9;
+  return( ( celsius + 2048 ) >> 12 );
+}
+
+
+
+/*
+ * Dew point by the Magnus formula with b = 17.62 and c = 243.12 C:
+ *   gamma = ln( RH ) + b T / ( c + T ),  Td = c gamma / ( b - gamma ).
+ * The logarithm comes from a 17-entry log2 table.
+ */
+int16_t dht_dew_point( int16_t temperature, int16_t humidity )
+{
+  if( humidity < 1 )
+  {
+    humidity = 1;
+  }
+  else if( humidity > 1000 )
+  {
+    humidity = 1000;
+  }
+
+  /* ln( RH / 100 % ) = ( log2( humidity ) - log2( 1000 ) ) ln 2, in Q12. */
+  int32_t gamma = ( ( log2_q12( humidity ) - 40820L ) * 45426L ) >> 16;
+
+  /* b T / ( c + T ) = 1762 t / ( 243120 + 100 t ), in Q12 with one extra
+     division step to stay within 32 bits. */
+  int32_t numerator = 1762L * temperature;
+  int32_t denominator = 243120L + 100L * temperature;
+  int32_t quotient = ( numerator << 10 ) / denominator;
+  int32_t remainder = ( numerator << 10 ) - quotient * denominator;
+  gamma += ( quotient << 2 ) + ( remainder << 2 ) / denominator;
+
+  /* Td = 243.12 gamma / ( 17.62 - gamma ), in tenths of a degree. */
+  int32_t top = 24312L * gamma;
+  int32_t bottom = 721715L - 10L * gamma;
+  return( ( top + ( top >= 0 ? bottom / 2 : -bottom / 2 ) ) / bottom );
+}
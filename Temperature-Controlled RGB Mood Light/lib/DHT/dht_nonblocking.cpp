@@ -27,10 +27,65 @@
 #define DHT_BEGIN_MEASUREMENT_2   2
 #define DHT_DO_READING            3
 #define DHT_COOLDOWN              4
+#define DHT_CAPTURING             5
+#define DHT_READ_FRAME            6
 
 
-/* Number of milliseconds before a new sensor read may be initiated. */
-#define COOLDOWN_TIME  2000
+/* Per sensor type: the minimum time between reads and the length of the
+   start signal, both in milliseconds.  The DHT11 wants at least 18 ms of
+   start signal, the DHT21 and DHT22 at least 1 ms. */
+struct DHT_timing
+{
+  uint16_t min_interval;
+  uint8_t start_signal;
+};
+static const DHT_timing dht_timing[ ] PROGMEM =
+{
+  { 1000, 18 },   /* DHT_TYPE_11 */
+  { 2000,  1 },   /* DHT_TYPE_21 */
+  { 2000,  1 }    /* DHT_TYPE_22 */
+};
+
+/* The line must have been released for this long before the start signal.
+   A line left released by the previous read already qualifies. */
+#define RELEASE_TIME  250
+
+/* After a bad frame (checksum error, or a pulse that never ended once the
+   sensor had answered), retry this soon, at most this many times in a row,
+   before falling back to the full interval.  A sensor that doesn't answer
+   at all always waits the full interval. */
+#define RETRY_TIME    250
+#define MAX_RETRIES   2
+
+/* A full frame takes about 5 ms; give up on the capture after this many. */
+#define CAPTURE_TIMEOUT  10
+
+
+DHT_nonblocking *DHT_nonblocking::timer_sensors = NULL;
+DHT_nonblocking *DHT_nonblocking::capture_sensors = NULL;
+
+
+#if DHT_CAPTURE && DHT_ISR
+/* All pin change groups share one handler; it ignores pins that aren't
+   being captured. */
+ISR( PCINT0_vect )
+{
+  DHT_nonblocking::capture_edge( );
+}
+#ifdef PCINT1_vect
+ISR( PCINT1_vect, ISR_ALIASOF( PCINT0_vect ) );
+#endif
+#ifdef PCINT2_vect
+ISR( PCINT2_vect, ISR_ALIASOF( PCINT0_vect ) );
+#endif
+
+/* Timer 0 drives millis( ) through its overflow; its compare B match fires
+   once per overflow period (1.024 ms at 16 MHz) and runs attached sensors. */
+ISR( TIMER0_COMPB_vect )
+{
+  DHT_nonblocking::timer_service( );
+}
+#endif
 
 
 /*
@@ -41,10 +96,36 @@ DHT_nonblocking::DHT_nonblocking( uint8_t pin, uint8_t type )
 	: _pin( pin ),
 	  _type( type ),
 	  _bit( digitalPinToBitMask( pin ) ),
-	  _port( digitalPinToPort( pin ) ),
-	  _maxcycles( microsecondsToClockCycles( 1000 ) )
+	  _port( digitalPinToPort( pin ) )
 {
   dht_state = DHT_IDLE;
+  _released = false;
+  _retries = 0;
+  _callback = NULL;
+
+  uint8_t timing = ( type <= DHT_TYPE_22 ) ? type : DHT_TYPE_22;
+  _min_interval = pgm_read_word( &dht_timing[ timing ].min_interval );
+  _start_signal = pgm_read_byte( &dht_timing[ timing ].start_signal );
+  _cooldown = _min_interval;
+  reset_stats( );
+  _next_timer = NULL;
+  _next_capture = NULL;
+  _capturing = false;
+
+#if DHT_CAPTURE
+  if( digitalPinToPCICR( pin ) != NULL )
+  {
+    _pcmsk     = digitalPinToPCMSK( pin );
+    _pcmsk_bit = digitalPinToPCMSKbit( pin );
+    _pcicr_bit = digitalPinToPCICRbit( pin );
+    _next_capture = capture_sensors;
+    capture_sensors = this;
+  }
+  else
+#endif
+  {
+    _pcmsk = NULL;
+  }
 
   pinMode( _pin, INPUT );
   digitalWrite( _pin, HIGH );
@@ -72,16 +153,151 @@ bool DHT_nonblocking::measure( float *temperature, float *humidity )
 
 
 
-float DHT_nonblocking::read_temperature( ) const
+/*
+ * Integer version of measure( ) that avoids floating point altogether.
+ * The temperature is in tenths of a degree Celsius, and the humidity is
+ * in tenths of a percent.
+ */
+bool DHT_nonblocking::measure( int16_t *temperature, int16_t *humidity )
+{
+  if( read_nonblocking( ) == true )
+  {
+    *temperature = read_temperature_deci( );
+    *humidity    = read_humidity_deci( );
+    return( true );
+  }
+  else
+  {
+    return( false );
+  }
+}
+
+
+
+/*
+ * The shortest time between two reads that this type of sensor allows, in
+ * milliseconds.
+ */
+uint16_t DHT_nonblocking::min_interval( ) const
+{
+  return( _min_interval );
+}
+
+
+
+/*
+ * Success and failure counts and pulse widths since the last reset_stats( ).
+ */
+const DHT_stats &DHT_nonblocking::stats( ) const
+{
+  return( _stats );
+}
+
+
+
+void DHT_nonblocking::reset_stats( )
+{
+  memset( &_stats, 0, sizeof( _stats ) );
+  _stats.low_min = 0xff;
+  _stats.high_min = 0xff;
+}
+
+
+
+/*
+ * True from the start of a measurement until its read has finished.
+ */
+bool DHT_nonblocking::is_measuring( ) const
+{
+  return( dht_state != DHT_IDLE && dht_state != DHT_COOLDOWN );
+}
+
+
+
+/*
+ * True while the last read failed and a quick retry is due.
+ */
+bool DHT_nonblocking::retry_pending( ) const
+{
+  return( _retries != 0 );
+}
+
+
+
+/*
+ * True when no measurement is in progress, so that the next call to
+ * measure( ) would start one.
+ */
+bool DHT_nonblocking::is_idle( ) const
+{
+  return( dht_state == DHT_IDLE );
+}
+
+
+
+/*
+ * Run the state machine from the timer 0 compare interrupt instead of
+ * polling measure( ).  The callback is invoked from interrupt context
+ * whenever a reading completes, successfully or not, and should only
+ * copy the values out.  Do not also call measure( ) for this sensor.
+ * Only a sensor whose frame is captured can be attached, since the
+ * blocking read would keep the interrupt busy for ~5 ms; returns false,
+ * leaving the sensor to measure( ), for any other.
+ */
+bool DHT_nonblocking::attach_timer( dht_callback_t callback )
+{
+#if DHT_CAPTURE
+  if( _pcmsk == NULL )
+  {
+    return( false );
+  }
+
+  uint8_t oldSREG = SREG;
+  noInterrupts( );
+  _callback = callback;
+  _next_timer = timer_sensors;
+  timer_sensors = this;
+  OCR0B = 128;
+  TIMSK0 |= _BV( OCIE0B );
+  SREG = oldSREG;
+  return( true );
+#else
+  (void) callback;
+  return( false );
+#endif
+}
+
+
+
+/* Attached sensors are all captured, so step( ) never leaves a frame for
+   the blocking read here. */
+void DHT_nonblocking::timer_service( )
+{
+  for( DHT_nonblocking *sensor = timer_sensors; sensor != NULL; sensor = sensor->_next_timer )
+  {
+    uint8_t previous_state = sensor->dht_state;
+    bool status = sensor->step( );
+    if( previous_state != DHT_COOLDOWN && sensor->dht_state == DHT_COOLDOWN )
+    {
+      sensor->_callback( sensor, status );
+    }
+  }
+}
+
+
+
+/*
+ * Temperature in tenths of a degree Celsius, or DHT_INVALID for an unknown
+ * sensor type.
+ */
+int16_t DHT_nonblocking::read_temperature_deci( ) const
 {
   int16_t value;
-  float   to_return;
 
   switch( _type )
   {
   case DHT_TYPE_11:
-    value = data[ 2 ];
-    to_return = (float) value;
+    value = data[ 2 ] * 10;
     break;
 
   case DHT_TYPE_21:
@@ -92,76 +308,127 @@ float DHT_nonblocking::read_temperature( ) const
     {
       value = -value;
     }
-    to_return = ( (float) value ) / 10.0;
     break;
 
   default:
-    to_return = NAN;
+    value = DHT_INVALID;
     break;
   }
 
-  return( to_return );
+  return( value );
 }
 
 
 
-float DHT_nonblocking::read_humidity( ) const
+/*
+ * Relative humidity in tenths of a percent, or DHT_INVALID for an unknown
+ * sensor type.
+ */
+int16_t DHT_nonblocking::read_humidity_deci( ) const
 {
-  uint16_t value;
-  float   to_return;
+  int16_t value;
 
   switch( _type )
   {
   case DHT_TYPE_11:
-    value =  data[ 0 ];
-    to_return = (float) value;
+    value = data[ 0 ] * 10;
     break;
 
   case DHT_TYPE_21:
   case DHT_TYPE_22:
     value =  data[ 0 ] << 8;
     value |= data[ 1 ];
-    to_return = (float)value / 10.0;
     break;
 
   default:
-    to_return = NAN;
+    value = DHT_INVALID;
     break;
   }
 
-  return( to_return );
+  return( value );
+}
+
+
+
+float DHT_nonblocking::read_temperature( ) const
+{
+  int16_t value = read_temperature_deci( );
+  return( value == DHT_INVALID ? NAN : value / 10.0 );
+}
+
+
+
+float DHT_nonblocking::read_humidity( ) const
+{
+  int16_t value = read_humidity_deci( );
+  return( value == DHT_INVALID ? NAN : value / 10.0 );
 }
 
 
 
 /*
- * Expect the input to be at the specified level and return the number
- * of loop cycles spent there.  This is identical to Adafruit's blocking
- * driver.
+ * Expect the input to be at the specified level and return the time spent
+ * there in microseconds, or DHT_PULSE_TIMEOUT after DHT_TIMEOUT_US.
  */
-uint32_t DHT_nonblocking::expect_pulse(bool level) const
+uint16_t DHT_nonblocking::expect_pulse( bool level ) const
 {
-  uint32_t count = 0;
   // On AVR platforms use direct GPIO port access as it's much faster and better
-  // for catching pulses that are 10's of microseconds in length:
+  // for catching pulses that are 10's of microseconds in length.  Timer 0
+  // keeps counting while interrupts are off, and a pulse never outlasts one
+  // turn of its 8-bit counter.
   #ifdef __AVR
+    volatile uint8_t *input = portInputRegister( _port );
     uint8_t portState = level ? _bit : 0;
-    while ((*portInputRegister(_port) & _bit) == portState) {
-      if (count++ >= _maxcycles) {
-        return 0; // Exceeded timeout, fail.
+    uint8_t start = TCNT0;
+    while( ( *input & _bit ) == portState )
+    {
+      if( (uint8_t) ( TCNT0 - start ) >= DHT_TIMEOUT_TICKS )
+      {
+        return( DHT_PULSE_TIMEOUT ); // Exceeded timeout, fail.
       }
     }
+    return( (uint8_t) ( TCNT0 - start ) * DHT_TICK_US );
   // Otherwise fall back to using digitalRead (this seems to be necessary on ESP8266
   // right now, perhaps bugs in direct port access functions?).
   #else
-    while (digitalRead(_pin) == level) {
-      if (count++ >= _maxcycles) {
-        return 0; // Exceeded timeout, fail.
+    unsigned long start = micros( );
+    while( digitalRead( _pin ) == level )
+    {
+      if( micros( ) - start >= DHT_TIMEOUT_US )
+      {
+        return( DHT_PULSE_TIMEOUT ); // Exceeded timeout, fail.
       }
     }
+    return( micros( ) - start );
   #endif
+}
+
+
 
-  return count;
+/*
+ * Advance the read and, when the frame is due, read it the blocking way
+ * with expect_pulse( ).
+ */
+bool DHT_nonblocking::read_nonblocking( )
+{
+  bool status = step( );
+  if( frame_due( ) == true )
+  {
+    status = read_data( );
+    end_read( status );
+  }
+  return( status );
+}
+
+
+
+/*
+ * True when step( ) has sent the start signal and the pin can't be captured,
+ * so the frame has to be read now.
+ */
+bool DHT_nonblocking::frame_due( ) const
+{
+  return( dht_state == DHT_READ_FRAME );
 }
 
 
@@ -169,7 +436,7 @@ uint32_t DHT_nonblocking::expect_pulse(bool level) const
 /*
  * State machine of the non-blocking read.
  */
-bool DHT_nonblocking::read_nonblocking( )
+bool DHT_nonblocking::step( )
 {
   bool status = false;
 
@@ -181,19 +448,29 @@ bool DHT_nonblocking::read_nonblocking( )
     break;
 
   /* Initiate a sensor read.  The read begins by going to high impedance
-     state for 250 ms. */
+     state for 250 ms, unless the previous read left it there long enough
+     ago already. */
   case DHT_BEGIN_MEASUREMENT:
     digitalWrite( _pin, HIGH );
     /* Reset 40 bits of received data to zero. */
     data[ 0 ] = data[ 1 ] = data[ 2 ] = data[ 3 ] = data[ 4 ] = 0;
+    if( _released == true && millis( ) - dht_timestamp > RELEASE_TIME )
+    {
+      pinMode( _pin, OUTPUT );
+      digitalWrite( _pin, LOW );
+      dht_state = DHT_DO_READING;
+    }
+    else
+    {
+      dht_state = DHT_BEGIN_MEASUREMENT_2;
+    }
     dht_timestamp = millis( );
-    dht_state = DHT_BEGIN_MEASUREMENT_2;
     break;
 
-  /* After the high impedance state, pull the pin low for 20 ms. */
+  /* After the high impedance state, pull the pin low for the start signal. */
   case DHT_BEGIN_MEASUREMENT_2:
     /* Wait for 250 ms. */
-    if( millis( ) - dht_timestamp > 250 )
+    if( millis( ) - dht_timestamp > RELEASE_TIME )
     {
       pinMode( _pin, OUTPUT );
       digitalWrite( _pin, LOW );
@@ -203,23 +480,26 @@ bool DHT_nonblocking::read_nonblocking( )
     break;
 
   case DHT_DO_READING:
-    /* Wait for 20 ms. */
-    if( millis( ) - dht_timestamp > 20 )
+    /* Wait for the sensor type's start signal time. */
+    if( millis( ) - dht_timestamp > _start_signal )
     {
       dht_timestamp = millis( );
-      dht_state = DHT_COOLDOWN;
-      status = read_data( );
-//      if( status != true )
-//      {
-//        Serial.println( "Reading failed" );
-//      }
+      dht_state = start_capture( ) == true ? DHT_CAPTURING : DHT_READ_FRAME;
+    }
+    break;
+
+  /* The pin change interrupt is timestamping the sensor's reply. */
+  case DHT_CAPTURING:
+    if( edge_count >= DHT_EDGES || millis( ) - dht_timestamp > CAPTURE_TIMEOUT )
+    {
+      status = finish_capture( );
+      end_read( status );
     }
     break;
 
-  /* If it has been less than two seconds since the last time we read
-     the sensor, then let the sensor cool down.. */
+  /* Let the sensor cool down until its next read is due. */
   case DHT_COOLDOWN:
-    if( millis( ) - dht_timestamp > COOLDOWN_TIME )
+    if( millis( ) - dht_timestamp > _cooldown )
     {
       dht_state = DHT_IDLE;
     }
@@ -234,83 +514,230 @@ bool DHT_nonblocking::read_nonblocking( )
 
 
 
-/* Read sensor data.  This is identical to Adafruit's blocking driver. */
+/*
+ * Schedule the next read after the one that just ended: a full interval
+ * after a good reading or no response, a quick retry after a bad frame
+ * unless the retries are used up.
+ */
+void DHT_nonblocking::end_read( bool status )
+{
+  dht_timestamp = millis( );
+  dht_state = DHT_COOLDOWN;
+  _released = true;
+
+  if( status == true )
+  {
+    ++_stats.ok;
+    _stats.last_error = DHT_ERROR_NONE;
+  }
+
+  bool bad_frame = status == false && _stats.last_error >= DHT_ERROR_DATA_LOW;
+  if( bad_frame == false || _retries >= MAX_RETRIES )
+  {
+    _retries = 0;
+    _cooldown = _min_interval;
+  }
+  else
+  {
+    ++_retries;
+    _cooldown = RETRY_TIME;
+  }
+}
+
+
+
+/* Record why a read failed.  Always returns false. */
+bool DHT_nonblocking::fail( uint8_t error )
+{
+  _stats.last_error = error;
+  if( error == DHT_ERROR_CHECKSUM )
+  {
+    ++_stats.checksum_errors;
+  }
+  else
+  {
+    ++_stats.timeouts[ error - DHT_ERROR_RESPONSE_LOW ];
+  }
+  return( false );
+}
+
+
+
+/*
+ * Fold the pulse widths of a complete frame into the statistics and check
+ * the checksum.
+ */
+bool DHT_nonblocking::check_frame( uint8_t low_min, uint8_t low_max, uint16_t low_sum,
+                                   uint8_t high_min, uint8_t high_max, uint16_t high_sum )
+{
+  if( low_min < _stats.low_min )
+  {
+    _stats.low_min = low_min;
+  }
+  if( low_max > _stats.low_max )
+  {
+    _stats.low_max = low_max;
+  }
+  if( high_min < _stats.high_min )
+  {
+    _stats.high_min = high_min;
+  }
+  if( high_max > _stats.high_max )
+  {
+    _stats.high_max = high_max;
+  }
+
+  uint8_t low_mean = low_sum / 40;
+  uint8_t high_mean = high_sum / 40;
+  if( _stats.low_mean == 0 )
+  {
+    _stats.low_mean = low_mean;
+    _stats.high_mean = high_mean;
+  }
+  else
+  {
+    _stats.low_mean += ( (int16_t) low_mean - _stats.low_mean ) / 8;
+    _stats.high_mean += ( (int16_t) high_mean - _stats.high_mean ) / 8;
+  }
+
+  if( data[ 4 ] != ( ( data[ 0 ] + data[ 1 ] + data[ 2 ] + data[ 3 ]) & 0xFF ) )
+  {
+    return( fail( DHT_ERROR_CHECKSUM ) );
+  }
+  return( true );
+}
+
+
+
+/* The blocking read, timed with the run-time port and bit of the pin. */
 bool DHT_nonblocking::read_data( )
 {
-  uint32_t cycles[ 80 ];
+  return( read_frame( [ this ]( bool level ) { return( expect_pulse( level ) ); } ) );
+}
+
 
-  /* Turn off interrupts temporarily because the next sections are timing critical
-     and we don't want any interruptions. */
+
+/*
+ * Release the data line and let the pin change interrupt timestamp the
+ * sensor's reply.  Returns false if the pin has no pin change interrupt,
+ * in which case the caller reads the sensor the blocking way.
+ */
+bool DHT_nonblocking::start_capture( )
+{
+#if DHT_CAPTURE
+  if( _pcmsk == NULL )
   {
-    volatile DHT_interrupt interrupt;
+    return( false );
+  }
+
+  uint8_t oldSREG = SREG;
+  noInterrupts( );
+  edge_count = 0;
+  edge_level = _bit;
+  edge_timestamp = micros( );
+  _capturing = true;
+
+  /* End the start signal, then hand the line to the sensor; the pull-up
+     stays on because the output latch is left high. */
+  digitalWrite( _pin, HIGH );
+  *_pcmsk |= _BV( _pcmsk_bit );
+  PCIFR = _BV( _pcicr_bit );
+  PCICR |= _BV( _pcicr_bit );
+  pinMode( _pin, INPUT );
+  SREG = oldSREG;
+  return( true );
+#else
+  return( false );
+#endif
+}
 
-    // End the start signal by setting data line high for 40 microseconds.
-    digitalWrite( _pin, HIGH );
-    delayMicroseconds( 40 );
 
-    // Now start reading the data line to get the value from the DHT sensor.
-    pinMode( _pin, INPUT );
-    // Delay a bit to let sensor pull data line low.
-    delayMicroseconds( 10 );
 
-    // First expect a low signal for ~80 microseconds followed by a high signal
-    // for ~80 microseconds again.
-    if( expect_pulse( LOW ) == 0 )
+/* Pin change interrupt: let every sensor that is capturing look at its pin. */
+void DHT_nonblocking::capture_edge( )
+{
+  for( DHT_nonblocking *sensor = capture_sensors; sensor != NULL; sensor = sensor->_next_capture )
+  {
+    if( sensor->_capturing == true )
     {
-      return( false );
+      sensor->record_edge( );
     }
-    if( expect_pulse( HIGH ) == 0 )
+  }
+}
+
+
+
+/* Record the width of the pulse that just ended, if the pin changed. */
+void DHT_nonblocking::record_edge( )
+{
+  uint8_t level = *portInputRegister( _port ) & _bit;
+  if( level == edge_level )
+  {
+    return;
+  }
+  edge_level = level;
+
+  unsigned long now = micros( );
+  unsigned long width = now - edge_timestamp;
+  edge_timestamp = now;
+  uint8_t count = edge_count;
+  if( count < DHT_EDGES )
+  {
+    edges[ count ] = ( width > 255 ) ? 255 : width;
+    edge_count = count + 1;
+  }
+}
+
+
+
+/* Stop capturing and decode the 40 bits from the recorded pulse widths. */
+bool DHT_nonblocking::finish_capture( )
+{
+#if DHT_CAPTURE
+  uint8_t oldSREG = SREG;
+  noInterrupts( );
+  *_pcmsk &= ~_BV( _pcmsk_bit );
+  _capturing = false;
+  SREG = oldSREG;
+#endif
+
+  /* Edges 0-2 end the sensor's wake-up, response low, and response high
+     pulses.  After that each bit is a ~50 us low pulse and a high pulse
+     that is ~28 us for a 0 and ~70 us for a 1.  A short capture names the
+     pulse that never ended. */
+  uint8_t count = edge_count;
+  if( count < DHT_EDGES )
+  {
+    if( count < 2 )
     {
-      return( false );
+      return( fail( DHT_ERROR_RESPONSE_LOW ) );
     }
-
-    // Now read the 40 bits sent by the sensor.  Each bit is sent as a 50
-    // microsecond low pulse followed by a variable length high pulse.  If the
-    // high pulse is ~28 microseconds then it's a 0 and if it's ~70 microseconds
-    // then it's a 1.  We measure the cycle count of the initial 50us low pulse
-    // and use that to compare to the cycle count of the high pulse to determine
-    // if the bit is a 0 (high state cycle count < low state cycle count), or a
-    // 1 (high state cycle count > low state cycle count). Note that for speed all
-    // the pulses are read into a array and then examined in a later step.
-    for( int i = 0; i < 80; i += 2 )
+    if( count == 2 )
     {
-      cycles[ i     ] = expect_pulse( LOW );
-      cycles[ i + 1 ] = expect_pulse( HIGH );
+      return( fail( DHT_ERROR_RESPONSE_HIGH ) );
     }
-
-    /* Timing critical code is now complete. */
+    return( fail( ( count & 1 ) ? DHT_ERROR_DATA_LOW : DHT_ERROR_DATA_HIGH ) );
   }
 
-  // Inspect pulses and determine which ones are 0 (high state cycle count < low
-  // state cycle count), or 1 (high state cycle count > low state cycle count).
+  uint8_t low_min = 0xff, low_max = 0, high_min = 0xff, high_max = 0;
+  uint16_t low_sum = 0, high_sum = 0;
   for( int i = 0; i < 40; ++i )
   {
-    uint32_t low_cycles  = cycles[ 2 * i     ];
-    uint32_t high_cycles = cycles[ 2 * i + 1 ];
-    if( ( low_cycles == 0 ) || ( high_cycles == 0 ) )
-    {
-      return( false );
-    }
+    uint8_t low  = edges[ 3 + 2 * i ];
+    uint8_t high = edges[ 4 + 2 * i ];
     data[ i / 8 ] <<= 1;
-    // Now compare the low and high cycle times to see if the bit is a 0 or 1.
-    if( high_cycles > low_cycles )
+    if( high > DHT_BIT_THRESHOLD_US )
     {
-      // High cycles are greater than 50us low cycle count, must be a 1.
       data[ i / 8 ] |= 1;
     }
-    // Else high cycles are less than (or equal to, a weird case) the 50us low
-    // cycle count so this must be a zero.  Nothing needs to be changed in the
-    // stored data.
-  }
 
-  // Check we read 40 bits and that the checksum matches.
-  if( data[ 4 ] == ( ( data[ 0 ] + data[ 1 ] + data[ 2 ] + data[ 3 ]) & 0xFF ) )
-  {
-    return( true );
+    low_sum += low;
+    high_sum += high;
+    if( low < low_min ) low_min = low;
+    if( low > low_max ) low_max = low;
+    if( high < high_min ) high_min = high;
+    if( high > high_max ) high_max = high;
   }
-  else
-  {
-    return( false );
-  }
-}
 
+  return( check_frame( low_min, low_max, low_sum, high_min, high_max, high_sum ) );
+}
@@ -33,41 +33,278 @@
 #define DHT_TYPE_21  1
 #define DHT_TYPE_22  2
 
+/* Returned by the integer readers for an unknown sensor type. */
+#define DHT_INVALID  INT16_MIN
+
+
+/* Interrupt-driven capture: on AVR, sensors on pins with a pin change
+   interrupt can be read by timestamping edges in the PCINT ISR instead of
+   busy-waiting with interrupts off.  This needs the PCINT0, PCINT1, PCINT2
+   and TIMER0_COMPB vectors, which SoftwareSerial, PinChangeInterrupt and
+   similar libraries define too; two definitions of a vector fail to link.
+   So the library claims them only when built with DHT_ISR 1, as a build
+   flag (-D DHT_ISR=1) since it has to reach dht_nonblocking.cpp as well.
+   With DHT_CAPTURE 1 and DHT_ISR 0 the library captures, but leaves the
+   vectors to the sketch, whose PCINT handlers must call
+   DHT_nonblocking::capture_edge( ) and whose TIMER0_COMPB handler must call
+   DHT_nonblocking::timer_service( ) if it attaches sensors to the timer.
+   By default neither is set and every read is the blocking one. */
+#ifndef DHT_ISR
+ #define DHT_ISR 0
+#endif
+
+#ifndef DHT_CAPTURE
+ #if defined( __AVR ) && defined( PCICR ) && DHT_ISR
+  #define DHT_CAPTURE 1
+ #else
+  #define DHT_CAPTURE 0
+ #endif
+#endif
+
+/* Pulse widths are measured in microseconds.  A data bit is a ~50 us low
+   pulse followed by a high pulse of ~26-28 us for a 0 and ~70 us for a 1. */
+#define DHT_TIMEOUT_US        1000
+#define DHT_BIT_THRESHOLD_US  48
+#define DHT_PULSE_TIMEOUT     0xFFFF
+
+/* On AVR the blocking read times pulses with timer 0, which the Arduino core
+   runs free at clock / 64 for millis( ): 4 us per tick at 16 MHz. */
+#define DHT_TICK_US        clockCyclesToMicroseconds( 64 )
+#define DHT_TIMEOUT_TICKS  ( DHT_TIMEOUT_US / DHT_TICK_US )
+
+/* Edges in a frame: the end of the host's release, the response low and
+   high pulses, then a low and a high pulse for each of the 40 data bits. */
+#define DHT_EDGES  83
+
+
+/* Why the last read failed.  The timeouts name the pulse that never ended. */
+#define DHT_ERROR_NONE           0
+#define DHT_ERROR_RESPONSE_LOW   1
+#define DHT_ERROR_RESPONSE_HIGH  2
+#define DHT_ERROR_DATA_LOW       3
+#define DHT_ERROR_DATA_HIGH      4
+#define DHT_ERROR_CHECKSUM       5
+
+/*
+ * Read telemetry, kept per sensor.  timeouts[ ] is indexed by the error
+ * code minus one.  Pulse widths are those of the 40 data bits, in
+ * microseconds saturated at 255; the high pulse minimum and maximum are in
+ * effect the widths of a 0 and a 1.  The means are running averages over
+ * reads, each read weighted 1/8.  masked_max is the longest time in
+ * microseconds that a blocking read has kept interrupts off; it stays 0
+ * while every frame is captured.
+ */
+struct DHT_stats
+{
+  uint16_t ok;
+  uint16_t checksum_errors;
+  uint16_t timeouts[ 4 ];
+  uint8_t low_min, low_max, low_mean;
+  uint8_t high_min, high_max, high_mean;
+  uint8_t last_error;
+  uint16_t masked_max;
+};
+
+
+class DHT_nonblocking;
+typedef void (*dht_callback_t)( DHT_nonblocking *sensor, bool success );
+
+
+class DHT_interrupt
+{
+  public:
+  DHT_interrupt( )
+  {
+    noInterrupts( );
+  }
+  ~DHT_interrupt( )
+  {
+    interrupts( );
+  }
+};
+
 
 class DHT_nonblocking
 {
   public:
     DHT_nonblocking( uint8_t pin, uint8_t type );
     bool measure( float *temperature, float *humidity );
+    bool measure( int16_t *temperature, int16_t *humidity );
+    bool attach_timer( dht_callback_t callback );
+    bool is_idle( ) const;
+    bool is_measuring( ) const;
+    bool retry_pending( ) const;
+    uint16_t min_interval( ) const;
+    const DHT_stats &stats( ) const;
+    void reset_stats( );
+    float read_temperature( ) const;
+    float read_humidity( ) const;
+    int16_t read_temperature_deci( ) const;
+    int16_t read_humidity_deci( ) const;
+
+    /* Interrupt entry points, not for use by sketches. */
+    static void capture_edge( );
+    static void timer_service( );
+
+  protected:
+    uint8_t data[ 6 ];
+
+    /* The read split up for DHT_static: step( ) advances the state machine
+       and returns true when a reading is complete.  If frame_due( ) is then
+       true, the caller reads the frame the blocking way with read_frame( ),
+       passing a function that times one pulse like expect_pulse( ), and
+       hands the result to end_read( ). */
+    bool step( );
+    bool frame_due( ) const;
+    template< typename Pulse > bool read_frame( Pulse expect );
+    void end_read( bool status );
+    uint16_t expect_pulse( bool level ) const;
 
   private:
     bool read_data( );
     bool read_nonblocking( );
-    float read_temperature( ) const;
-    float read_humidity( ) const;
+    bool start_capture( );
+    bool finish_capture( );
+    void record_edge( );
+    bool fail( uint8_t error );
+    bool check_frame( uint8_t low_min, uint8_t low_max, uint16_t low_sum,
+                      uint8_t high_min, uint8_t high_max, uint16_t high_sum );
 
-    uint8_t dht_state;
+    /* Advanced by timer_service( ) in interrupt context for attached
+       sensors, and read by is_idle( ) and is_measuring( ) from the loop. */
+    volatile uint8_t dht_state;
     unsigned long dht_timestamp;
-    uint8_t data[ 6 ];
+    uint16_t _min_interval, _cooldown;
+    uint8_t _start_signal;
+    uint8_t _retries;
+    bool _released;
+    DHT_stats _stats;
     const uint8_t _pin, _type, _bit, _port;
-    const uint32_t _maxcycles;
 
-    uint32_t expect_pulse( bool level ) const;
+    /* Edge capture.  Each entry is the width in microseconds, saturated
+       at 255, of the pulse that the edge ended.  Every sensor on a pin
+       change interrupt is on the capture_sensors list, and the ISR records
+       edges for those whose _capturing is set. */
+    volatile uint8_t *_pcmsk;
+    uint8_t _pcmsk_bit, _pcicr_bit;
+    volatile bool _capturing;
+    volatile uint8_t edge_count;
+    volatile uint8_t edge_level;
+    volatile unsigned long edge_timestamp;
+    volatile uint8_t edges[ DHT_EDGES ];
+
+    dht_callback_t _callback;
+    DHT_nonblocking *_next_timer;
+    DHT_nonblocking *_next_capture;
+    static DHT_nonblocking *timer_sensors;
+    static DHT_nonblocking *capture_sensors;
 };
 
 
-class DHT_interrupt
+/* Read sensor data.  This follows Adafruit's blocking driver, except that
+   each bit is decoded as soon as its high pulse ends rather than keeping
+   all 80 pulse counts on the stack.  expect( level ) must behave like
+   expect_pulse( ); it is a template argument so that a fixed pulse timer
+   can be inlined into the loop.  The time spent with interrupts off is the
+   sum of the delays and the pulses, and goes into the statistics. */
+template< typename Pulse >
+bool DHT_nonblocking::read_frame( Pulse expect )
 {
-  public:
-  DHT_interrupt( )
+  uint8_t low_min = 0xff, low_max = 0, high_min = 0xff, high_max = 0;
+  uint16_t low_sum = 0, high_sum = 0;
+  uint16_t masked = 40 + 10;
+  uint8_t error = DHT_ERROR_NONE;
+  auto timed = [ & ]( bool level )
   {
-    noInterrupts( );
+    uint16_t width = expect( level );
+    masked += ( width == DHT_PULSE_TIMEOUT ) ? DHT_TIMEOUT_US : width;
+    return( width );
+  };
+
+  /* Turn off interrupts temporarily because the next sections are timing critical
+     and we don't want any interruptions. */
+  {
+    volatile DHT_interrupt interrupt;
+
+    // End the start signal by setting data line high for 40 microseconds.
+    digitalWrite( _pin, HIGH );
+    delayMicroseconds( 40 );
+
+    // Now start reading the data line to get the value from the DHT sensor.
+    pinMode( _pin, INPUT );
+    // Delay a bit to let sensor pull data line low.
+    delayMicroseconds( 10 );
+
+    // First expect a low signal for ~80 microseconds followed by a high signal
+    // for ~80 microseconds again.
+    if( timed( LOW ) == DHT_PULSE_TIMEOUT )
+    {
+      error = DHT_ERROR_RESPONSE_LOW;
+    }
+    else if( timed( HIGH ) == DHT_PULSE_TIMEOUT )
+    {
+      error = DHT_ERROR_RESPONSE_HIGH;
+    }
+
+    // Now read the 40 bits sent by the sensor.  Each bit is sent as a 50
+    // microsecond low pulse followed by a variable length high pulse.  If the
+    // high pulse is ~28 microseconds then it's a 0 and if it's ~70 microseconds
+    // then it's a 1.  The high pulse is classified against an absolute
+    // threshold halfway between the two.  The compare and shift take a
+    // handful of cycles out of the next 50us low pulse, which is well inside
+    // the margin between the two pulse lengths.  The same goes for keeping
+    // the running pulse width statistics.
+    for( uint8_t i = 0; i < 40 && error == DHT_ERROR_NONE; ++i )
+    {
+      uint16_t low_width  = timed( LOW );
+      if( low_width == DHT_PULSE_TIMEOUT )
+      {
+        error = DHT_ERROR_DATA_LOW;
+        break;
+      }
+      uint16_t high_width = timed( HIGH );
+      if( high_width == DHT_PULSE_TIMEOUT )
+      {
+        error = DHT_ERROR_DATA_HIGH;
+        break;
+      }
+      data[ i / 8 ] <<= 1;
+      if( high_width > DHT_BIT_THRESHOLD_US )
+      {
+        data[ i / 8 ] |= 1;
+      }
+
+      uint8_t low  = ( low_width  > 255 ) ? 255 : low_width;
+      uint8_t high = ( high_width > 255 ) ? 255 : high_width;
+      low_sum += low;
+      high_sum += high;
+      if( low < low_min ) low_min = low;
+      if( low > low_max ) low_max = low;
+      if( high < high_min ) high_min = high;
+      if( high > high_max ) high_max = high;
+    }
+
+    /* Timing critical code is now complete. */
   }
-  ~DHT_interrupt( )
+
+  if( masked > _stats.masked_max )
   {
-    interrupts( );
+    _stats.masked_max = masked;
   }
-};
+  if( error != DHT_ERROR_NONE )
+  {
+    return( fail( error ) );
+  }
+
+  // Check we read 40 bits and that the checksum matches.
+  return( check_frame( low_min, low_max, low_sum, high_min, high_max, high_sum ) );
+}
+
+
+/* Fixed-point comfort figures, all in tenths of a degree Celsius from a
+   temperature in tenths of a degree and a humidity in tenths of a percent. */
+int16_t dht_heat_index( int16_t temperature, int16_t humidity );
+int16_t dht_dew_point( int16_t temperature, int16_t humidity );
 
 
 #endif /* _DHT_NONBLOCKING_H */
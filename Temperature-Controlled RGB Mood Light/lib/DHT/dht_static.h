@@ -0,0 +1,204 @@
+/*
+ * Compile-time specialization of the DHT non-blocking library.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef _DHT_STATIC_H
+#define _DHT_STATIC_H
+
+#include "dht_nonblocking.h"
+
+
+/*
+ * Arduino pin number to input register and bit, as constant expressions so
+ * that the polling loop compiles to a single sbis/sbic on a fixed address.
+ * Each pin is encoded as ( port << 3 ) | bit, with the port indexing
+ * dht_pin_register.  Boards without a table fall back to the run-time
+ * lookup of DHT_nonblocking.
+ */
+#if defined( __AVR_ATmega2560__ ) || defined( __AVR_ATmega1280__ )
+ #define DHT_STATIC_PINS 70
+/* PINA to PINL; there is no port I. */
+constexpr uint16_t dht_pin_register[ ] =
+{
+  0x20, 0x23, 0x26, 0x29, 0x2C, 0x2F, 0x32, 0x100, 0x103, 0x106, 0x109
+};
+enum { DHT_PA, DHT_PB, DHT_PC, DHT_PD, DHT_PE, DHT_PF, DHT_PG, DHT_PH, DHT_PJ, DHT_PK, DHT_PL };
+constexpr uint8_t dht_pin_map[ DHT_STATIC_PINS ] =
+{
+  /*  0 */ DHT_PE << 3 | 0, DHT_PE << 3 | 1, DHT_PE << 3 | 4, DHT_PE << 3 | 5,
+  /*  4 */ DHT_PG << 3 | 5, DHT_PE << 3 | 3, DHT_PH << 3 | 3, DHT_PH << 3 | 4,
+  /*  8 */ DHT_PH << 3 | 5, DHT_PH << 3 | 6, DHT_PB << 3 | 4, DHT_PB << 3 | 5,
+  /* 12 */ DHT_PB << 3 | 6, DHT_PB << 3 | 7, DHT_PJ << 3 | 1, DHT_PJ << 3 | 0,
+  /* 16 */ DHT_PH << 3 | 1, DHT_PH << 3 | 0, DHT_PD << 3 | 3, DHT_PD << 3 | 2,
+  /* 20 */ DHT_PD << 3 | 1, DHT_PD << 3 | 0, DHT_PA << 3 | 0, DHT_PA << 3 | 1,
+  /* 24 */ DHT_PA << 3 | 2, DHT_PA << 3 | 3, DHT_PA << 3 | 4, DHT_PA << 3 | 5,
+  /* 28 */ DHT_PA << 3 | 6, DHT_PA << 3 | 7, DHT_PC << 3 | 7, DHT_PC << 3 | 6,
+  /* 32 */ DHT_PC << 3 | 5, DHT_PC << 3 | 4, DHT_PC << 3 | 3, DHT_PC << 3 | 2,
+  /* 36 */ DHT_PC << 3 | 1, DHT_PC << 3 | 0, DHT_PD << 3 | 7, DHT_PG << 3 | 2,
+  /* 40 */ DHT_PG << 3 | 1, DHT_PG << 3 | 0, DHT_PL << 3 | 7, DHT_PL << 3 | 6,
+  /* 44 */ DHT_PL << 3 | 5, DHT_PL << 3 | 4, DHT_PL << 3 | 3, DHT_PL << 3 | 2,
+  /* 48 */ DHT_PL << 3 | 1, DHT_PL << 3 | 0, DHT_PB << 3 | 3, DHT_PB << 3 | 2,
+  /* 52 */ DHT_PB << 3 | 1, DHT_PB << 3 | 0, DHT_PF << 3 | 0, DHT_PF << 3 | 1,
+  /* 56 */ DHT_PF << 3 | 2, DHT_PF << 3 | 3, DHT_PF << 3 | 4, DHT_PF << 3 | 5,
+  /* 60 */ DHT_PF << 3 | 6, DHT_PF << 3 | 7, DHT_PK << 3 | 0, DHT_PK << 3 | 1,
+  /* 64 */ DHT_PK << 3 | 2, DHT_PK << 3 | 3, DHT_PK << 3 | 4, DHT_PK << 3 | 5,
+  /* 68 */ DHT_PK << 3 | 6, DHT_PK << 3 | 7
+};
+#elif defined( __AVR_ATmega328P__ ) || defined( __AVR_ATmega168__ )
+ #define DHT_STATIC_PINS 20
+/* PINB, PINC, PIND. */
+constexpr uint16_t dht_pin_register[ ] = { 0x23, 0x26, 0x29 };
+enum { DHT_PB, DHT_PC, DHT_PD };
+constexpr uint8_t dht_pin_map[ DHT_STATIC_PINS ] =
+{
+  DHT_PD << 3 | 0, DHT_PD << 3 | 1, DHT_PD << 3 | 2, DHT_PD << 3 | 3,
+  DHT_PD << 3 | 4, DHT_PD << 3 | 5, DHT_PD << 3 | 6, DHT_PD << 3 | 7,
+  DHT_PB << 3 | 0, DHT_PB << 3 | 1, DHT_PB << 3 | 2, DHT_PB << 3 | 3,
+  DHT_PB << 3 | 4, DHT_PB << 3 | 5, DHT_PC << 3 | 0, DHT_PC << 3 | 1,
+  DHT_PC << 3 | 2, DHT_PC << 3 | 3, DHT_PC << 3 | 4, DHT_PC << 3 | 5
+};
+#endif
+
+
+
+/*
+ * A DHT sensor whose pin and type are template arguments:
+ *
+ *   DHT_static<10, DHT_TYPE_22> dht;
+ *
+ * It offers the polling API of DHT_nonblocking and shares its state machine,
+ * but nothing is virtual: the decoders are compiled for the one sensor type,
+ * and the blocking frame read is instantiated with a pulse timer that polls
+ * a constant register with a constant mask and timeout.  The blocking read is
+ * used on pins without a pin change interrupt, or with DHT_CAPTURE 0; on the
+ * others the frame is captured from the interrupt as usual and only the
+ * decoders differ.
+ *
+ * It is not a DHT_nonblocking, so it can't be handed to a DHT_bus or
+ * attached to the timer interrupt.
+ */
+template< uint8_t Pin, uint8_t Type >
+class DHT_static : protected DHT_nonblocking
+{
+  static_assert( Type <= DHT_TYPE_22, "DHT_static: unknown sensor type" );
+#ifdef DHT_STATIC_PINS
+  static_assert( Pin < DHT_STATIC_PINS, "DHT_static: no such pin" );
+#endif
+
+  public:
+    DHT_static( ) : DHT_nonblocking( Pin, Type )
+    {
+    }
+
+    using DHT_nonblocking::is_idle;
+    using DHT_nonblocking::is_measuring;
+    using DHT_nonblocking::retry_pending;
+    using DHT_nonblocking::min_interval;
+    using DHT_nonblocking::stats;
+    using DHT_nonblocking::reset_stats;
+
+    bool measure( int16_t *temperature, int16_t *humidity )
+    {
+      if( read_static( ) == true )
+      {
+        *temperature = read_temperature_deci( );
+        *humidity    = read_humidity_deci( );
+        return( true );
+      }
+      return( false );
+    }
+
+    bool measure( float *temperature, float *humidity )
+    {
+      if( read_static( ) == true )
+      {
+        *temperature = read_temperature( );
+        *humidity    = read_humidity( );
+        return( true );
+      }
+      return( false );
+    }
+
+    int16_t read_temperature_deci( ) const
+    {
+      if( Type == DHT_TYPE_11 )
+      {
+        return( data[ 2 ] * 10 );
+      }
+      int16_t value = ( ( data[ 2 ] & 0x7f ) << 8 ) | data[ 3 ];
+      return( ( data[ 2 ] & 0x80 ) != 0 ? -value : value );
+    }
+
+    int16_t read_humidity_deci( ) const
+    {
+      if( Type == DHT_TYPE_11 )
+      {
+        return( data[ 0 ] * 10 );
+      }
+      return( ( data[ 0 ] << 8 ) | data[ 1 ] );
+    }
+
+    float read_temperature( ) const
+    {
+      return( read_temperature_deci( ) / 10.0 );
+    }
+
+    float read_humidity( ) const
+    {
+      return( read_humidity_deci( ) / 10.0 );
+    }
+
+  protected:
+#ifdef DHT_STATIC_PINS
+    /* Same loop as DHT_nonblocking::expect_pulse( ), but with nothing left
+       to load from the object inside it. */
+    static uint16_t expect_pulse( bool level )
+    {
+      const uint8_t mask = 1 << ( dht_pin_map[ Pin ] & 7 );
+      volatile uint8_t *const input =
+        (volatile uint8_t *) (uintptr_t) dht_pin_register[ dht_pin_map[ Pin ] >> 3 ];
+      const uint8_t state = level ? mask : 0;
+      uint8_t start = TCNT0;
+
+      while( ( *input & mask ) == state )
+      {
+        if( (uint8_t) ( TCNT0 - start ) >= DHT_TIMEOUT_TICKS )
+        {
+          return( DHT_PULSE_TIMEOUT );
+        }
+      }
+      return( (uint8_t) ( TCNT0 - start ) * DHT_TICK_US );
+    }
+#else
+    using DHT_nonblocking::expect_pulse;
+#endif
+
+  private:
+    bool read_static( )
+    {
+      bool status = step( );
+      if( frame_due( ) == true )
+      {
+        status = read_frame( [ this ]( bool level ) { return( expect_pulse( level ) ); } );
+        end_read( status );
+      }
+      return( status );
+    }
+};
+
+
+#endif /* _DHT_STATIC_H */
@@ -0,0 +1,166 @@
+#include "scheduler.h"
+
+Scheduler::Scheduler(Task *tasks, uint8_t count, SchedulerClock clock)
+    : tasks(tasks), count(count), clock(clock), heapSize(0),
+      windowStart(0), busyUs(0), lastOccupancy(0) {
+  if (this->count > schedulerMaxTasks) this->count = schedulerMaxTasks;
+  for (uint8_t id = 0; id < this->count; id++) tasks[id].slot = noSlot;
+}
+
+void Scheduler::begin() {
+  uint32_t now = clock();
+  windowStart = now;
+  for (uint8_t id = 0; id < count; id++) {
+    if (tasks[id].periodUs > 0) {
+      remove(id);
+      tasks[id].due = now + tasks[id].periodUs;
+      push(id);
+    }
+  }
+}
+
+void Scheduler::start(uint8_t id, uint32_t delayUs) {
+  if (id >= count) return;
+  remove(id);
+  tasks[id].due = clock() + delayUs;
+  push(id);
+}
+
+void Scheduler::stop(uint8_t id) {
+  if (id < count) remove(id);
+}
+
+bool Scheduler::pending(uint8_t id) const {
+  return id < count && tasks[id].slot != noSlot;
+}
+
+// Heap order: earlier due time first, then lower priority number
+bool Scheduler::earlier(uint8_t a, uint8_t b) const {
+  int32_t difference = tasks[a].due - tasks[b].due;
+  if (difference != 0) return difference < 0;
+  return tasks[a].priority < tasks[b].priority;
+}
+
+void Scheduler::place(uint8_t slot, uint8_t id) {
+  heap[slot] = id;
+  tasks[id].slot = slot;
+}
+
+void Scheduler::siftUp(uint8_t slot) {
+  uint8_t id = heap[slot];
+  while (slot > 0) {
+    uint8_t parent = (slot - 1) / 2;
+    if (!earlier(id, heap[parent])) break;
+    place(slot, heap[parent]);
+    slot = parent;
+  }
+  place(slot, id);
+}
+
+void Scheduler::siftDown(uint8_t slot) {
+  uint8_t id = heap[slot];
+  for (;;) {
+    uint8_t child = 2 * slot + 1;
+    if (child >= heapSize) break;
+    if (child + 1 < heapSize && earlier(heap[child + 1], heap[child])) child++;
+    if (!earlier(heap[child], id)) break;
+    place(slot, heap[child]);
+    slot = child;
+  }
+  place(slot, id);
+}
+
+void Scheduler::push(uint8_t id) {
+  place(heapSize, id);
+  heapSize++;
+  siftUp(heapSize - 1);
+}
+
+void Scheduler::remove(uint8_t id) {
+  uint8_t slot = tasks[id].slot;
+  if (slot == noSlot) return;
+  tasks[id].slot = noSlot;
+  heapSize--;
+  if (slot == heapSize) return;
+  // Fill the hole with the last entry and restore the order around it
+  place(slot, heap[heapSize]);
+  if (slot > 0 && earlier(heap[slot], heap[(slot - 1) / 2])) {
+    siftUp(slot);
+  } else {
+    siftDown(slot);
+  }
+}
+
+uint32_t Scheduler::run() {
+  uint32_t now = clock();
+
+  uint32_t elapsed = now - windowStart;
+  if (elapsed >= windowUs) {
+    uint32_t perMille = elapsed / 1000;
+    lastOccupancy = perMille > 0 ? busyUs / perMille : 0;
+    windowStart = now;
+    busyUs = 0;
+  }
+
+  // At most one pass over the table, so a task that is always due can't
+  // keep run() from returning
+  for (uint8_t ran = 0; ran < count && heapSize > 0; ran++) {
+    uint8_t id = heap[0];
+    Task &task = tasks[id];
+    int32_t wait = task.due - now;
+    if (wait > 0) return wait;
+
+    remove(id);
+    uint32_t late = now - task.due;
+    uint32_t deadline = task.deadlineUs > 0 ? task.deadlineUs : task.periodUs;
+    if (deadline > 0 && late > deadline) task.misses++;
+    if (late > task.maxLateUs) task.maxLateUs = late;
+
+    // Reschedule first, so the task can stop or restart itself. A periodic
+    // task keeps its phase; runs it is too late for are skipped, not queued.
+    if (task.periodUs > 0) {
+      task.due += task.periodUs;
+      if ((int32_t)(task.due - now) <= 0) {
+        task.due += ((now - task.due) / task.periodUs + 1) * task.periodUs;
+      }
+      push(id);
+    }
+
+    task.run();
+    uint32_t end = clock();
+    uint32_t runTime = end - now;
+    if (runTime > task.maxRunUs) task.maxRunUs = runTime;
+    task.runs++;
+    busyUs += runTime;
+    now = end;
+  }
+
+  if (heapSize == 0) return 0xFFFFFFFF;
+  int32_t wait = tasks[heap[0]].due - now;
+  return wait > 0 ? wait : 0;
+}
+
+const Task &Scheduler::task(uint8_t id) const {
+  return tasks[id];
+}
+
+uint16_t Scheduler::occupancy() const {
+  return lastOccupancy;
+}
+
+uint32_t Scheduler::longestRunUs() const {
+  uint32_t longest = 0;
+  for (uint8_t id = 0; id < count; id++) {
+    if (tasks[id].maxRunUs > longest) longest = tasks[id].maxRunUs;
+  }
+  return longest;
+}
+
+void Scheduler::resetStats() {
+  for (uint8_t id = 0; id < count; id++) {
+    tasks[id].runs = 0;
+    tasks[id].misses = 0;
+    tasks[id].maxLateUs = 0;
+    tasks[id].maxRunUs = 0;
+  }
+}
@@ -0,0 +1,151 @@
+#include <Arduino.h>
+#include "alert_patterns.h"
+
+// Timer5 runs free at F_CPU / 64: 4 us per tick at 16 MHz
+const uint32_t ticksPerMs = F_CPU / 64 / 1000;
+// Longer phases are scheduled in steps of this many ticks
+const uint16_t maxStep = 0x8000;
+
+enum Phase : uint8_t { PHASE_ON, PHASE_OFF, PHASE_PAUSE };
+
+struct Player {
+  AlertPattern pattern;
+  AlertOutput output;
+  uint32_t remaining; // Ticks left in this phase after the scheduled compare
+  Phase phase;
+  uint8_t repeat;
+  uint8_t cycle;
+  uint8_t priority;
+  volatile bool active;
+};
+
+static Player players[ALERT_CHANNELS];
+
+// Schedule the next compare match for the channel
+static void scheduleStep(Player &player, volatile uint16_t &ocr) {
+  uint16_t step = player.remaining > maxStep ? maxStep : player.remaining;
+  ocr += step;
+  player.remaining -= step;
+}
+
+// Move to the next phase with a non-zero length. Returns false once the
+// pattern has finished.
+static bool nextPhase(Player &player) {
+  const AlertPattern &pattern = player.pattern;
+  uint16_t duration;
+  do {
+    switch (player.phase) {
+      case PHASE_ON:
+        player.phase = PHASE_OFF;
+        player.output(false);
+        duration = pattern.offMs;
+        break;
+      case PHASE_OFF:
+        if (++player.repeat < pattern.repeats) {
+          player.phase = PHASE_ON;
+          player.output(true);
+          duration = pattern.onMs;
+        } else {
+          player.phase = PHASE_PAUSE;
+          duration = pattern.pauseMs;
+        }
+        break;
+      default: // PHASE_PAUSE
+        if (pattern.cycles != 0 && ++player.cycle >= pattern.cycles) {
+          player.active = false;
+          return false;
+        }
+        player.repeat = 0;
+        player.phase = PHASE_ON;
+        player.output(true);
+        duration = pattern.onMs;
+        break;
+    }
+  } while (duration == 0);
+
+  player.remaining = duration * ticksPerMs;
+  return true;
+}
+
+static void service(uint8_t channel, volatile uint16_t &ocr, uint8_t enableBit) {
+  Player &player = players[channel];
+  if (player.active && (player.remaining > 0 || nextPhase(player))) {
+    scheduleStep(player, ocr);
+  } else {
+    TIMSK5 &= ~_BV(enableBit);
+  }
+}
+
+ISR(TIMER5_COMPA_vect) {
+  service(ALERT_BUZZER, OCR5A, OCIE5A);
+}
+
+ISR(TIMER5_COMPB_vect) {
+  service(ALERT_LED, OCR5B, OCIE5B);
+}
+
+void alertBegin(AlertOutput buzzer, AlertOutput led) {
+  players[ALERT_BUZZER].output = buzzer;
+  players[ALERT_LED].output = led;
+  TCCR5A = 0;                       // Normal mode, outputs disconnected
+  TCCR5B = _BV(CS51) | _BV(CS50);   // clk / 64
+  TIMSK5 = 0;
+}
+
+static volatile uint16_t &compareRegister(uint8_t channel) {
+  return channel == ALERT_BUZZER ? OCR5A : OCR5B;
+}
+
+static uint8_t compareEnable(uint8_t channel) {
+  return channel == ALERT_BUZZER ? OCIE5A : OCIE5B;
+}
+
+bool alertPlay(uint8_t channel, const AlertPattern *pattern, uint8_t priority) {
+  if (channel >= ALERT_CHANNELS) return false;
+  Player &player = players[channel];
+
+  uint8_t oldSREG = SREG;
+  noInterrupts();
+  if (player.active && player.priority > priority) {
+    SREG = oldSREG;
+    return false;
+  }
+  memcpy_P(&player.pattern, pattern, sizeof(AlertPattern));
+  if (player.pattern.onMs == 0) {
+    SREG = oldSREG;
+    return false;
+  }
+  player.priority = priority;
+  player.phase = PHASE_ON;
+  player.repeat = 0;
+  player.cycle = 0;
+  player.active = true;
+  player.output(true);
+  player.remaining = player.pattern.onMs * ticksPerMs;
+
+  volatile uint16_t &ocr = compareRegister(channel);
+  ocr = TCNT5;
+  scheduleStep(player, ocr);
+  TIFR5 = _BV(channel == ALERT_BUZZER ? OCF5A : OCF5B); // Drop any stale match
+  TIMSK5 |= _BV(compareEnable(channel));
+  SREG = oldSREG;
+  return true;
+}
+
+void alertCancel(uint8_t channel, uint8_t priority) {
+  if (channel >= ALERT_CHANNELS) return;
+  Player &player = players[channel];
+
+  uint8_t oldSREG = SREG;
+  noInterrupts();
+  if (player.active && player.priority <= priority) {
+    player.active = false;
+    TIMSK5 &= ~_BV(compareEnable(channel));
+    player.output(false);
+  }
+  SREG = oldSREG;
+}
+
+bool alertPlaying(uint8_t channel) {
+  return channel < ALERT_CHANNELS && players[channel].active;
+}
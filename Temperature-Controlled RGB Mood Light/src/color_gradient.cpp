@@ -0,0 +1,81 @@
+#include <Arduino.h>
+#include "color_gradient.h"
+
+// Colour stops, evenly spaced over the range
+const uint8_t gradientStops = 5;
+const RGB gradientTable[gradientStops] PROGMEM = {
+  {  0,   0, 255}, // Cold: blue
+  {  0, 255, 255}, // Cyan
+  {  0, 255,   0}, // Comfortable: green
+  {255, 255,   0}, // Yellow
+  {255,   0,   0}  // Hot: red
+};
+
+// Position along the ramp in 1/256 of a segment, from 0 at coldC to
+// (gradientStops - 1) * 256 at hotC
+const int32_t rampEnd = (int32_t)(gradientStops - 1) << 8;
+
+static int16_t coldC = 150;   // 15.0 °C
+static int16_t hotC = 350;    // 35.0 °C
+static int32_t rampScale = (rampEnd << 16) / (350 - 150); // ramp units per 0.1 °C, Q16
+
+bool gradientSetRange(int16_t newColdC, int16_t newHotC) {
+  if (newColdC >= newHotC) return false;
+  coldC = newColdC;
+  hotC = newHotC;
+  // Precomputed so that mapping a temperature needs no division
+  rampScale = (rampEnd << 16) / (newHotC - newColdC);
+  return true;
+}
+
+int16_t gradientColdC() {
+  return coldC;
+}
+
+int16_t gradientHotC() {
+  return hotC;
+}
+
+static uint8_t blend(uint8_t from, uint8_t to, uint16_t frac) {
+  return from + (((int16_t)to - from) * frac) / 256;
+}
+
+RGB gradientTarget(int16_t tempC) {
+  int32_t pos;
+  if (tempC <= coldC) {
+    pos = 0;
+  } else if (tempC >= hotC) {
+    pos = rampEnd;
+  } else {
+    pos = ((int32_t)(tempC - coldC) * rampScale + 0x8000) >> 16;
+  }
+
+  uint8_t seg = pos >> 8;
+  uint16_t frac = pos & 0xFF;
+  if (seg == gradientStops - 1) { // Exactly at the hot end
+    seg--;
+    frac = 256;
+  }
+  RGB from, to, out;
+  memcpy_P(&from, &gradientTable[seg], sizeof(RGB));
+  memcpy_P(&to, &gradientTable[seg + 1], sizeof(RGB));
+  out.r = blend(from.r, to.r, frac);
+  out.g = blend(from.g, to.g, frac);
+  out.b = blend(from.b, to.b, frac);
+  return out;
+}
+
+static uint8_t approach(uint8_t shown, uint8_t target) {
+  int16_t diff = (int16_t)target - shown;
+  int16_t step = diff / 8;
+  if (step == 0 && diff != 0) step = diff > 0 ? 1 : -1; // Always finish the fade
+  return shown + step;
+}
+
+bool gradientStep(RGB &shown, const RGB &target) {
+  if (shown.r == target.r && shown.g == target.g && shown.b == target.b) return false;
+  shown.r = approach(shown.r, target.r);
+  shown.g = approach(shown.g, target.g);
+  shown.b = approach(shown.b, target.b);
+  return true;
+}
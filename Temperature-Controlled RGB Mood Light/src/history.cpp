@@ -0,0 +1,236 @@
+#include <Arduino.h>
+#include "history.h"
+
+const uint8_t codeEscape = 0xF0; // Changes follow as varints
+const uint8_t codeGap = 0xF1;    // Missed readings follow as a varint
+const uint8_t maxRecord = 11;    // Gap (1 + 3) and escaped reading (1 + 3 + 3)
+
+struct Block {
+  uint32_t startAt, endAt; // First and last reading
+  uint16_t steps;          // Periods from the first reading to the last
+  int16_t firstTemp, firstHumidity;
+  int16_t minTemp, maxTemp, minHumidity, maxHumidity;
+  int32_t sumTemp, sumHumidity;
+  uint16_t samples;
+  uint8_t used; // Data bytes
+};
+
+static uint8_t data[historyBlocks][historyBlockBytes];
+static Block blocks[historyBlocks];
+static uint16_t newest = 0;    // Sequence number of the block being filled
+static uint8_t blockCount = 0;
+static uint16_t period = 2000;
+static uint32_t lastAt;
+static int16_t lastTemp, lastHumidity;
+
+static uint16_t zigzag(int16_t value) {
+  return ((uint16_t)value << 1) ^ (uint16_t)(value >> 15);
+}
+
+static int16_t unzigzag(uint16_t value) {
+  return (int16_t)(value >> 1) ^ -(int16_t)(value & 1);
+}
+
+static uint8_t putVarint(uint8_t *out, uint8_t length, uint16_t value) {
+  while (value >= 0x80) {
+    out[length++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  out[length++] = value;
+  return length;
+}
+
+static uint16_t getVarint(const uint8_t *bytes, uint8_t &offset) {
+  uint16_t value = 0;
+  uint8_t shift = 0;
+  uint8_t byte;
+  do {
+    byte = bytes[offset++];
+    value |= (uint16_t)(byte & 0x7F) << shift;
+    shift += 7;
+  } while (byte & 0x80);
+  return value;
+}
+
+static uint16_t oldest() {
+  return blockCount > 0 ? newest - (blockCount - 1) : newest;
+}
+
+static Block &blockFor(uint16_t sequence) {
+  return blocks[sequence % historyBlocks];
+}
+
+static void count(Block &block, int16_t temp, int16_t humidity) {
+  if (temp < block.minTemp) block.minTemp = temp;
+  if (temp > block.maxTemp) block.maxTemp = temp;
+  if (humidity < block.minHumidity) block.minHumidity = humidity;
+  if (humidity > block.maxHumidity) block.maxHumidity = humidity;
+  block.sumTemp += temp;
+  block.sumHumidity += humidity;
+  block.samples++;
+}
+
+// Open a new block with this reading in its header, dropping the oldest
+// block if they are all in use
+static void startBlock(uint32_t takenAt, int16_t temp, int16_t humidity) {
+  if (blockCount > 0) newest++;
+  if (blockCount < historyBlocks) blockCount++;
+  Block &block = blockFor(newest);
+  block.startAt = block.endAt = takenAt;
+  block.steps = 0;
+  block.firstTemp = block.minTemp = block.maxTemp = temp;
+  block.firstHumidity = block.minHumidity = block.maxHumidity = humidity;
+  block.sumTemp = temp;
+  block.sumHumidity = humidity;
+  block.samples = 1;
+  block.used = 0;
+}
+
+void historyBegin(uint16_t periodMs) {
+  period = periodMs;
+  newest = 0;
+  blockCount = 0;
+}
+
+void historyAdd(uint32_t takenAt, int16_t temp, int16_t humidity) {
+  if (blockCount > 0) {
+    // Readings since the last one, to the nearest period
+    uint32_t elapsed = takenAt - lastAt;
+    uint32_t steps = 1;
+    if (elapsed >= period + period / 2) steps = (elapsed + period / 2) / period;
+
+    Block &block = blockFor(newest);
+    if (steps <= 0xFFFFUL - block.steps && block.used + maxRecord <= historyBlockBytes) {
+      uint8_t *out = data[newest % historyBlocks];
+      uint8_t length = block.used;
+      if (steps > 1) {
+        out[length++] = codeGap;
+        length = putVarint(out, length, steps - 1);
+      }
+      uint16_t tempChange = zigzag(temp - lastTemp);
+      uint16_t humidityChange = zigzag(humidity - lastHumidity);
+      if (tempChange < 15 && humidityChange < 15) {
+        out[length++] = tempChange << 4 | humidityChange;
+      } else {
+        out[length++] = codeEscape;
+        length = putVarint(out, length, tempChange);
+        length = putVarint(out, length, humidityChange);
+      }
+      block.used = length;
+      block.endAt = takenAt;
+      block.steps += steps;
+      count(block, temp, humidity);
+      lastAt = takenAt;
+      lastTemp = temp;
+      lastHumidity = humidity;
+      return;
+    }
+  }
+  startBlock(takenAt, temp, humidity);
+  lastAt = takenAt;
+  lastTemp = temp;
+  lastHumidity = humidity;
+}
+
+uint16_t historySamples() {
+  uint16_t samples = 0;
+  for (uint8_t i = 0; i < blockCount; i++) samples += blocks[i].samples;
+  return samples;
+}
+
+uint16_t historyBytesUsed() {
+  uint16_t used = 0;
+  for (uint8_t i = 0; i < blockCount; i++) used += blocks[i].used;
+  return used;
+}
+
+bool historySummary(uint32_t now, uint32_t windowMs, HistorySummary *summary) {
+  if (blockCount == 0) return false;
+  summary->samples = 0;
+  int32_t sumTemp = 0, sumHumidity = 0;
+  uint32_t endAt = lastAt; // Time of the block's last reading (about)
+  for (uint8_t i = 0; i < blockCount; i++) {
+    const Block &block = blockFor(newest - i);
+    if (now - endAt > windowMs) break;
+    if (summary->samples == 0) {
+      summary->minTemp = block.minTemp;
+      summary->maxTemp = block.maxTemp;
+      summary->minHumidity = block.minHumidity;
+      summary->maxHumidity = block.maxHumidity;
+    } else {
+      summary->minTemp = min(summary->minTemp, block.minTemp);
+      summary->maxTemp = max(summary->maxTemp, block.maxTemp);
+      summary->minHumidity = min(summary->minHumidity, block.minHumidity);
+      summary->maxHumidity = max(summary->maxHumidity, block.maxHumidity);
+    }
+    summary->samples += block.samples;
+    summary->fromAt = block.startAt;
+    sumTemp += block.sumTemp;
+    sumHumidity += block.sumHumidity;
+    endAt = block.startAt;
+  }
+  if (summary->samples == 0) return false;
+  int32_t half = summary->samples / 2;
+  summary->meanTemp = (sumTemp + (sumTemp >= 0 ? half : -half)) / summary->samples;
+  summary->meanHumidity = (sumHumidity + half) / summary->samples;
+  return true;
+}
+
+// Readings are spread evenly between the block's first and last reading
+// times, so retry delays don't add up along the block
+static uint32_t readingTime(const Block &block, uint16_t step) {
+  if (step == 0) return block.startAt;
+  uint32_t span = block.endAt - block.startAt;
+  uint32_t each = span / block.steps;
+  uint32_t rest = span % block.steps;
+  return block.startAt + each * step + rest * step / block.steps;
+}
+
+void historyRewind(HistoryCursor &cursor) {
+  cursor.block = oldest();
+  cursor.offset = 0;
+  cursor.step = 0;
+  cursor.started = false;
+}
+
+bool historyNext(HistoryCursor &cursor, uint32_t *at, int16_t *temp, int16_t *humidity) {
+  if (blockCount == 0) return false;
+  // The block being read has been dropped: carry on from the oldest
+  if ((int16_t)(cursor.block - oldest()) < 0) historyRewind(cursor);
+
+  const Block *block = &blockFor(cursor.block);
+  if (cursor.started && cursor.offset >= block->used) {
+    if (cursor.block == newest) return false;
+    cursor.block++;
+    cursor.offset = 0;
+    cursor.step = 0;
+    cursor.started = false;
+    block = &blockFor(cursor.block);
+  }
+
+  if (!cursor.started) {
+    cursor.started = true;
+    cursor.temp = block->firstTemp;
+    cursor.humidity = block->firstHumidity;
+  } else {
+    const uint8_t *bytes = data[cursor.block % historyBlocks];
+    uint8_t code = bytes[cursor.offset++];
+    uint16_t steps = 1;
+    if (code == codeGap) {
+      steps += getVarint(bytes, cursor.offset);
+      code = bytes[cursor.offset++];
+    }
+    if (code == codeEscape) {
+      cursor.temp += unzigzag(getVarint(bytes, cursor.offset));
+      cursor.humidity += unzigzag(getVarint(bytes, cursor.offset));
+    } else {
+      cursor.temp += unzigzag(code >> 4);
+      cursor.humidity += unzigzag(code & 0x0F);
+    }
+    cursor.step += steps;
+  }
+  *at = readingTime(*block, cursor.step);
+  *temp = cursor.temp;
+  *humidity = cursor.humidity;
+  return true;
+}
@@ -1,6 +1,13 @@
 // Libraries & Initialization
 #include <Arduino.h>
-#include <DHT.h> // DHT sensor library from Adafruit
+#include <dht_nonblocking.h> // Non-blocking DHT driver in lib/DHT
+#include "temp_filter.h"
+#include "temp_trend.h"
+#include "history.h"
+#include "color_gradient.h"
+#include "alert_patterns.h"
+#include "report.h"
+#include <scheduler.h> // Task scheduler in lib/Scheduler
 
 // Pin Connections & Objects
 // RGB LED Pins
@@ -13,127 +20,507 @@ const int buzzerPin = 9;
 
 // DHT22 Sensor Pin
 const int DHTPIN = 10;
-DHT dht(DHTPIN, DHT22); // Initialize DHT sensor
-
-// Non-blocking alert state variables for buzzer and LED
-bool alertActive = false;
-unsigned long alertStartTime = 0;
-unsigned long lastBuzzerTime = 0;
-unsigned long lastRedFlashTime = 0;
-int buzzerCount = 0;
-bool buzzerOn = false;
-bool redLedOn = false;
-
-const unsigned long buzzerInterval = 400;      // Interval between buzzer pulses (ms)
-const unsigned long buzzerPause = 5000;        // Pause after 3 buzzes (ms)
-const unsigned long buzzerPulseDuration = 200; // Buzzer ON duration (ms)
-const unsigned long redFlashInterval = 200;    // Red LED flash interval (ms)
+DHT_nonblocking dht(DHTPIN, DHT_TYPE_22); // Initialize DHT sensor
 
-// Start alert: buzzer and flashing red LED
-void startTempAlert() {
-  alertActive = true;
-  alertStartTime = millis();
-  lastBuzzerTime = millis();
-  lastRedFlashTime = millis();
-  buzzerCount = 0;
-  buzzerOn = false;
-  redLedOn = false;
-  Serial.println("Temperature Alert!");
+// Latest sensor sample. Only Celsius and humidity are stored, in tenths as
+// the sensor reports them; Fahrenheit and heat index are derived from them
+// when something asks for them.
+struct Sample {
+  int16_t tempC;    // 0.1 °C
+  int16_t humidity; // 0.1 %
+  int16_t smoothC;  // 0.1 °C, median + EMA filtered
+  unsigned long takenAt; // millis() of the reading
+  bool valid;
+};
+Sample sample = {0, 0, 0, 0, false};
+
+// Temperature bands (0.1 °C): cold below 20, hot from 30, and a reading has to
+// get 0.5 °C past a threshold before the band changes
+const BandConfig bands = {200, 300, 5};
+TempFilter tempFilter;
+TempBand band = BAND_UNKNOWN;
+
+// Pre-alert: warn when the temperature trend reaches the hot alert within
+// this many seconds (0 turns it off) and is rising at least preAlertMinRate,
+// so sensor noise near the threshold doesn't set it off. It clears once the
+// projection is more than twice the horizon away.
+TempTrend tempTrend;
+uint16_t preAlertHorizon = 120;
+const int16_t preAlertMinRate = 3; // 0.1 °C per minute
+bool preAlerting = false;
+
+// LED colour: the gradient target for the smoothed temperature, and the colour
+// currently shown, which fades toward it
+RGB targetColor = {0, 0, 0};
+RGB shownColor = {0, 0, 0};
+
+// History dump in progress, streamed as the serial queue has room
+bool dumping = false;
+HistoryCursor dumpCursor;
+uint16_t dumpedReadings = 0;
+
+// Serial command line
+char commandLine[32];
+uint8_t commandLength = 0;
+
+// Longest single pass through loop() (us)
+unsigned long maxLoopMicros = 0;
+
+// Alert patterns, played by Timer5 (see alert_patterns.h)
+// High temperature: three 200 ms beeps 400 ms apart, every 5 s
+const AlertPattern tempAlertBeep PROGMEM = {200, 400, 3, 3200, 0};
+// High temperature: red LED flashing at 200 ms
+const AlertPattern tempAlertFlash PROGMEM = {200, 200, 1, 0, 0};
+
+// Rising toward hot: a short chirp every 10 s
+const AlertPattern preAlertChirp PROGMEM = {50, 0, 1, 9950, 0};
+
+const uint8_t preAlertPriority = 0;
+const uint8_t tempAlertPriority = 1;
+
+// Celsius to Fahrenheit, both in tenths of a degree
+int16_t toFahrenheit(int16_t tenthsC) {
+  int32_t tenthsF = 18L * tenthsC + 3200;
+  return (tenthsF + (tenthsF >= 0 ? 5 : -5)) / 10;
 }
 
-void setup() {
-  // Initialize pin modes
-  pinMode(redRGBLED, OUTPUT);
-  pinMode(blueRGBLED, OUTPUT);
-  pinMode(greenRGBLED, OUTPUT);
-  pinMode(buzzerPin, OUTPUT);
-  delay(1000);      // Allow sensor to power up
-  dht.begin();      // Start DHT sensor
-  Serial.begin(9600); // Start serial communication
+int16_t sampleTempF() {
+  return toFahrenheit(sample.tempC);
 }
 
-unsigned long lastReadTime = 0;
-const unsigned long readInterval = 2000; // Sensor read interval (ms)
+int16_t sampleHeatIndexC() {
+  return dht_heat_index(sample.tempC, sample.humidity);
+}
 
-void loop() {
-  unsigned long currentTime = millis(); // Current time (ms)
-
-  // Sensor reading logic
-  if (currentTime - lastReadTime >= readInterval) {
-    lastReadTime = currentTime;
-    float humidity = dht.readHumidity();
-    float tempC = dht.readTemperature();
-    float tempF = dht.readTemperature(true);
-
-    // Check for sensor errors
-    if (isnan(humidity) || isnan(tempC) || isnan(tempF)) {
-      Serial.println("Failed to read from DHT22! Check wiring and pull-up resistor.");
+int16_t sampleHeatIndexF() {
+  return toFahrenheit(sampleHeatIndexC());
+}
+
+// Print a value held in tenths, e.g. 239 as "23.9"
+void printTenths(int16_t value) {
+  if (value < 0) {
+    reportOut.print('-');
+    value = -value;
+  }
+  reportOut.print(value / 10);
+  reportOut.print('.');
+  reportOut.print(value % 10);
+}
+
+void showColor(const RGB &color) {
+  analogWrite(redRGBLED, color.r);
+  analogWrite(greenRGBLED, color.g);
+  analogWrite(blueRGBLED, color.b);
+}
+
+// Parse a temperature like "21", "-3.5" or "18.25" into tenths (extra digits
+// are dropped). Advances text past it; returns false if there is no number.
+bool parseTenths(const char *&text, int16_t *tenths) {
+  while (*text == ' ') text++;
+  bool negative = (*text == '-');
+  if (negative) text++;
+  if (!isDigit(*text)) return false;
+  int16_t value = 0;
+  while (isDigit(*text)) value = value * 10 + (*text++ - '0');
+  value *= 10;
+  if (*text == '.') {
+    text++;
+    if (isDigit(*text)) value += *text++ - '0';
+    while (isDigit(*text)) text++;
+  }
+  *tenths = negative ? -value : value;
+  return true;
+}
+
+// "range" shows the gradient range; "range <cold> <hot>" sets it (°C)
+void rangeCommand(const char *args) {
+  int16_t cold, hot;
+  if (parseTenths(args, &cold)) {
+    if (!parseTenths(args, &hot) || !gradientSetRange(cold, hot)) {
+      reportOut.println(F("Usage: range <cold °C> <hot °C>, cold below hot"));
       return;
     }
+    if (sample.valid) targetColor = gradientTarget(sample.smoothC);
+  }
+  reportOut.print(F("Gradient: blue at "));
+  printTenths(gradientColdC());
+  reportOut.print(F("°C, red at "));
+  printTenths(gradientHotC());
+  reportOut.println(F("°C"));
+}
 
-    // LED and alert logic based on temperature
-    if (tempC < 20) {
-      digitalWrite(blueRGBLED, HIGH);   // Cold: blue
-      digitalWrite(greenRGBLED, LOW);
-      digitalWrite(redRGBLED, LOW);
-      alertActive = false;
-    } else if (tempC >= 20 && tempC < 30) {
-      digitalWrite(blueRGBLED, LOW);
-      digitalWrite(greenRGBLED, HIGH); // Comfortable: green
-      digitalWrite(redRGBLED, LOW);
+// "format" shows the reading format; "format text|csv|binary" sets it
+void formatCommand(const char *args) {
+  while (*args == ' ') args++;
+  if (*args != '\0') {
+    if (strcmp(args, "text") == 0) {
+      reportSetFormat(REPORT_TEXT);
+    } else if (strcmp(args, "csv") == 0) {
+      reportSetFormat(REPORT_CSV);
+    } else if (strcmp(args, "binary") == 0) {
+      reportSetFormat(REPORT_BINARY);
     } else {
-      digitalWrite(blueRGBLED, LOW);
-      digitalWrite(greenRGBLED, LOW);
-      startTempAlert();                // Hot: start alert
+      reportOut.println(F("Usage: format text|csv|binary"));
+      return;
     }
+  }
+  reportOut.print(F("Format: "));
+  reportOut.print(reportFormatName(reportFormat()));
+  reportOut.print(F(", dropped "));
+  reportOut.println(reportDropped());
+}
+
+// "horizon" shows the pre-alert horizon; "horizon <s>" sets it (0 = off)
+void horizonCommand(const char *args) {
+  while (*args == ' ') args++;
+  if (*args != '\0') {
+    if (!isDigit(*args)) {
+      reportOut.println(F("Usage: horizon <seconds>"));
+      return;
+    }
+    preAlertHorizon = min(atol(args), 3600L);
+  }
+  reportOut.print(F("Pre-alert horizon: "));
+  reportOut.print(preAlertHorizon);
+  reportOut.println(F(" s"));
+}
+
+// "history" summarises the stored readings; "history <minutes>" also
+// summarises the last few minutes
+void historyCommand(const char *args) {
+  reportOut.print(F("History: "));
+  reportOut.print(historySamples());
+  reportOut.print(F(" readings in "));
+  reportOut.print(historyBytesUsed());
+  reportOut.println(F(" bytes"));
+
+  while (*args == ' ') args++;
+  uint32_t windowMs = isDigit(*args) ? atol(args) * 60000UL : 0xFFFFFFFF;
+  HistorySummary summary;
+  if (!historySummary(millis(), windowMs, &summary)) return;
+  reportOut.print(summary.samples);
+  reportOut.print(F(" readings from "));
+  reportOut.print((millis() - summary.fromAt) / 1000);
+  reportOut.print(F(" s ago: "));
+  printTenths(summary.minTemp);
+  reportOut.print('-');
+  printTenths(summary.maxTemp);
+  reportOut.print(F("°C (mean "));
+  printTenths(summary.meanTemp);
+  reportOut.print(F("), "));
+  printTenths(summary.minHumidity);
+  reportOut.print('-');
+  printTenths(summary.maxHumidity);
+  reportOut.print(F("% (mean "));
+  printTenths(summary.meanHumidity);
+  reportOut.println(')');
+}
+
+// "dump" streams the stored readings as CSV, oldest first
+void dumpCommand() {
+  historyRewind(dumpCursor);
+  dumpedReadings = 0;
+  dumping = true;
+  reportOut.println(F("ms,tempC,humidity"));
+}
 
-    // Print sensor readings to Serial
-    float heatIndexC = dht.computeHeatIndex(tempC, humidity, false);
-    float heatIndexF = dht.computeHeatIndex(tempF, humidity, true);
-    Serial.print("Humidity: ");
-    Serial.print(humidity);
-    Serial.print("% | Temperatures: ");
-    Serial.print(tempC);
-    Serial.print("°C, ");
-    Serial.print(tempF);
-    Serial.print("°F, Heat Indexs: ");
-    Serial.print(heatIndexC);
-    Serial.print("°C, ");
-    Serial.print(heatIndexF);
-    Serial.println("°F");
-  }
-
-  // Non-blocking alert logic for buzzer and red LED
-  if (alertActive) {
-    unsigned long now = millis();
-    // Flash red LED
-    if (now - lastRedFlashTime >= redFlashInterval) {
-      lastRedFlashTime = now;
-      redLedOn = !redLedOn;
-      digitalWrite(redRGBLED, redLedOn ? HIGH : LOW);
+// Queue dump lines while the serial queue has room for one (24 bytes at
+// most) and still for a text reading, so live readings aren't dropped
+void dumpStep() {
+  while (dumping && reportRoom() >= 24 + 96) {
+    uint32_t at;
+    int16_t temp, humidity;
+    if (!historyNext(dumpCursor, &at, &temp, &humidity)) {
+      dumping = false;
+      reportOut.print(F("End of history, "));
+      reportOut.print(dumpedReadings);
+      reportOut.println(F(" readings"));
+      return;
     }
-    // Buzzer pulse logic
-    if (buzzerCount < 3) {
-      if (!buzzerOn && now - lastBuzzerTime >= buzzerInterval) {
-        buzzerOn = true;
-        lastBuzzerTime = now;
-        digitalWrite(buzzerPin, HIGH);
-      } else if (buzzerOn && now - lastBuzzerTime >= buzzerPulseDuration) {
-        buzzerOn = false;
-        lastBuzzerTime = now;
-        digitalWrite(buzzerPin, LOW);
-        buzzerCount++;
+    reportOut.print(at);
+    reportOut.print(',');
+    printTenths(temp);
+    reportOut.print(',');
+    printTenths(humidity);
+    reportOut.println();
+    dumpedReadings++;
+  }
+}
+
+void tasksCommand();
+
+void runCommand(const char *line) {
+  if (strncmp(line, "range", 5) == 0) {
+    rangeCommand(line + 5);
+  } else if (strncmp(line, "format", 6) == 0) {
+    formatCommand(line + 6);
+  } else if (strncmp(line, "horizon", 7) == 0) {
+    horizonCommand(line + 7);
+  } else if (strncmp(line, "history", 7) == 0) {
+    historyCommand(line + 7);
+  } else if (strcmp(line, "dump") == 0) {
+    dumpCommand();
+  } else if (strcmp(line, "tasks") == 0) {
+    tasksCommand();
+  } else {
+    reportOut.println(F("Commands: range [<cold °C> <hot °C>], format [text|csv|binary], horizon [<s>], history [<min>], dump, tasks"));
+  }
+}
+
+// Collect serial input without blocking and run each complete line
+void pollSerialCommands() {
+  while (Serial.available() > 0) {
+    char ch = Serial.read();
+    if (ch == '\n' || ch == '\r') {
+      if (commandLength > 0) {
+        commandLine[commandLength] = '\0';
+        runCommand(commandLine);
+        commandLength = 0;
       }
-    } else {
-      // Pause before restarting buzzer sequence
-      if (now - alertStartTime >= buzzerPause) {
-        buzzerCount = 0;
-        alertStartTime = now;
+    } else if (commandLength < sizeof(commandLine) - 1) {
+      commandLine[commandLength++] = ch;
+    }
+  }
+}
+
+// Alert outputs, switched from the timer interrupt
+void buzzerOutput(bool on) {
+  digitalWrite(buzzerPin, on ? HIGH : LOW);
+}
+
+void redFlashOutput(bool on) {
+  digitalWrite(redRGBLED, on ? HIGH : LOW);
+}
+
+// Start alert: buzzer and flashing red LED
+void startTempAlert() {
+  digitalWrite(blueRGBLED, LOW);
+  digitalWrite(greenRGBLED, LOW);
+  alertPlay(ALERT_BUZZER, &tempAlertBeep, tempAlertPriority);
+  alertPlay(ALERT_LED, &tempAlertFlash, tempAlertPriority);
+  reportOut.println(F("Temperature Alert!"));
+}
+
+const unsigned long staleTimeout = 5000; // No reading for this long is an error (ms)
+bool staleReported = false;
+uint16_t reportedFailures = 0;
+
+// Total failed reads so far
+uint16_t dhtFailures() {
+  const DHT_stats &stats = dht.stats();
+  return stats.checksum_errors + stats.timeouts[0] + stats.timeouts[1] +
+         stats.timeouts[2] + stats.timeouts[3];
+}
+
+// Report why the last read failed, with the running counters, so that a long
+// or noisy cable (checksum errors, stretched pulses) can be told apart from a
+// missing or dead sensor (no response).
+void printFailure() {
+  const DHT_stats &stats = dht.stats();
+  reportOut.print(F("DHT22 read failed: "));
+  switch (stats.last_error) {
+    case DHT_ERROR_RESPONSE_LOW:  reportOut.print(F("no response")); break;
+    case DHT_ERROR_RESPONSE_HIGH: reportOut.print(F("response stuck high")); break;
+    case DHT_ERROR_DATA_LOW:      reportOut.print(F("data low timeout")); break;
+    case DHT_ERROR_DATA_HIGH:     reportOut.print(F("data high timeout")); break;
+    case DHT_ERROR_CHECKSUM:      reportOut.print(F("checksum")); break;
+    default:                      reportOut.print(F("unknown")); break;
+  }
+  reportOut.print(F(" | ok "));
+  reportOut.print(stats.ok);
+  reportOut.print(F(", checksum "));
+  reportOut.print(stats.checksum_errors);
+  reportOut.print(F(", timeouts "));
+  for (uint8_t i = 0; i < 4; i++) {
+    if (i > 0) reportOut.print('/');
+    reportOut.print(stats.timeouts[i]);
+  }
+  reportOut.print(F(" | low "));
+  reportOut.print(stats.low_min);
+  reportOut.print('-');
+  reportOut.print(stats.low_max);
+  reportOut.print(F(" us, high "));
+  reportOut.print(stats.high_min);
+  reportOut.print('-');
+  reportOut.print(stats.high_max);
+  reportOut.print(F(" us | masked "));
+  reportOut.print(stats.masked_max);
+  reportOut.println(F(" us"));
+}
+
+// Queue the sample for the serial port. Fahrenheit and heat index are only
+// worked out here.
+void reportReading() {
+  ReportSample report;
+  report.takenAt = sample.takenAt;
+  report.tempC = sample.tempC;
+  report.humidity = sample.humidity;
+  report.tempF = sampleTempF();
+  report.heatIndexC = sampleHeatIndexC();
+  report.heatIndexF = sampleHeatIndexF();
+  report.maxLoopUs = maxLoopMicros;
+  reportSample(report);
+}
+
+// Raise or clear the pre-alert from the projected time to the hot alert.
+// The hot alert itself replaces it, having the higher priority.
+void updatePreAlert() {
+  if (band == BAND_HOT) {
+    preAlerting = false;
+    return;
+  }
+  uint16_t period = dht.min_interval();
+  uint32_t timeToHot = trendTimeTo(tempTrend, bands.hotFrom + bands.hysteresis, period);
+  uint32_t horizonMs = preAlertHorizon * 1000UL;
+  int16_t rate = trendPerMinute(tempTrend, period);
+
+  if (!preAlerting && preAlertHorizon > 0 && timeToHot <= horizonMs &&
+      rate >= preAlertMinRate) {
+    preAlerting = true;
+    alertPlay(ALERT_BUZZER, &preAlertChirp, preAlertPriority);
+    reportOut.print(F("Warming "));
+    printTenths(rate);
+    reportOut.print(F("°C/min, hot in about "));
+    reportOut.print(timeToHot / 1000);
+    reportOut.println(F(" s"));
+  } else if (preAlerting && (preAlertHorizon == 0 || timeToHot > 2 * horizonMs)) {
+    preAlerting = false;
+    alertCancel(ALERT_BUZZER, preAlertPriority);
+    reportOut.println(F("Warming eased"));
+  }
+}
+
+// Tasks
+
+// Sensor reading logic: the driver reads every 2 seconds on its own and
+// returns true once a fresh sample is ready.
+void pollSensor() {
+  unsigned long currentTime = millis();
+  int16_t tempC, humidity;
+  if (dht.measure(&tempC, &humidity)) {
+    sample.tempC = tempC;
+    sample.humidity = humidity;
+    sample.takenAt = currentTime;
+    sample.smoothC = filterAdd(tempFilter, tempC);
+    trendAdd(tempTrend, tempC);
+    historyAdd(currentTime, tempC, humidity);
+    sample.valid = true;
+    staleReported = false;
+
+    // LED colour follows the smoothed temperature along the gradient
+    targetColor = gradientTarget(sample.smoothC);
+
+    // Alert logic, only when the smoothed temperature changes band
+    TempBand previousBand = band;
+    if (bandUpdate(&band, bands, sample.smoothC)) {
+      if (band == BAND_HOT) {
+        startTempAlert();                // Hot: start alert
+      } else if (previousBand == BAND_HOT) {
+        // Stop the hot alert only; a pre-alert chirp is updatePreAlert's
+        alertCancel(ALERT_BUZZER, tempAlertPriority);
+        alertCancel(ALERT_LED, tempAlertPriority);
+        showColor(shownColor);           // Hand the LED back to the gradient
       }
     }
-  } else {
-    // Ensure buzzer and red LED are off when not alerting
-    digitalWrite(buzzerPin, LOW);
-    digitalWrite(redRGBLED, LOW);
+    updatePreAlert();
+
+    // Send sensor readings to Serial
+    reportReading();
+  }
+
+  // Report each failed read once
+  uint16_t failures = dhtFailures();
+  if (failures != reportedFailures) {
+    reportedFailures = failures;
+    printFailure();
+  }
+}
+
+// Check for sensor errors
+void checkStale() {
+  if (!staleReported && millis() - sample.takenAt >= staleTimeout) {
+    sample.valid = false;
+    staleReported = true;
+    reportOut.println(F("Failed to read from DHT22! Check wiring and pull-up resistor."));
+  }
+}
+
+void serviceSerial() {
+  pollSerialCommands();
+  dumpStep();
+}
+
+// Fade the LED toward the gradient colour, unless the alert (played from
+// Timer5) is flashing it
+void fadeStep() {
+  if (!alertPlaying(ALERT_LED) && gradientStep(shownColor, targetColor)) {
+    showColor(shownColor);
+  }
+}
+
+enum { TASK_SENSOR, TASK_REPORT, TASK_FADE, TASK_SERIAL, TASK_STALE, TASK_COUNT };
+
+// Run, period (us), priority
+Task tasks[TASK_COUNT] = {
+  {pollSensor, 1000, 0},       // Keep the DHT driver moving
+  {reportPump, 5000, 1},       // Feed the UART (64 bytes last 66 ms at 9600)
+  {fadeStep, 20000, 2},        // Fade step interval
+  {serviceSerial, 10000, 3},   // Commands and history dump
+  {checkStale, 500000, 4},
+};
+
+Scheduler scheduler(tasks, TASK_COUNT, micros);
+
+const __FlashStringHelper *taskName(uint8_t id) {
+  switch (id) {
+    case TASK_SENSOR: return F("sensor");
+    case TASK_REPORT: return F("report");
+    case TASK_FADE:   return F("fade");
+    case TASK_SERIAL: return F("serial");
+    default:          return F("stale");
+  }
+}
+
+// "tasks" shows the scheduler's counters and how busy the loop is
+void tasksCommand() {
+  for (uint8_t id = 0; id < TASK_COUNT; id++) {
+    const Task &task = scheduler.task(id);
+    reportOut.print(taskName(id));
+    reportOut.print(F(": runs "));
+    reportOut.print(task.runs);
+    reportOut.print(F(", misses "));
+    reportOut.print(task.misses);
+    reportOut.print(F(", late max "));
+    reportOut.print(task.maxLateUs);
+    reportOut.print(F(" us, run max "));
+    reportOut.print(task.maxRunUs);
+    reportOut.println(F(" us"));
   }
-}
\ No newline at end of file
+  reportOut.print(F("Occupancy: "));
+  printTenths(scheduler.occupancy());
+  reportOut.println('%');
+}
+
+void setup() {
+  // Initialize pin modes
+  pinMode(redRGBLED, OUTPUT);
+  pinMode(blueRGBLED, OUTPUT);
+  pinMode(greenRGBLED, OUTPUT);
+  pinMode(buzzerPin, OUTPUT);
+  alertBegin(buzzerOutput, redFlashOutput);
+  Serial.begin(9600); // Start serial communication
+  filterReset(tempFilter);
+  trendReset(tempTrend);
+  historyBegin(dht.min_interval());
+  scheduler.begin();
+  scheduler.start(TASK_SENSOR, 1000000); // Allow sensor to power up
+}
+
+void loop() {
+  unsigned long loopStart = micros();
+  scheduler.run();
+  unsigned long loopTime = micros() - loopStart;
+  if (loopTime > maxLoopMicros) {
+    maxLoopMicros = loopTime;
+  }
+}
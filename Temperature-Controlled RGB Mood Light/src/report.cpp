@@ -0,0 +1,186 @@
+#include <Arduino.h>
+#include "report.h"
+
+// TX ring of 256 bytes, so the 8-bit indices wrap by themselves. One slot is
+// kept free to tell a full ring from an empty one.
+static uint8_t ring[256];
+static uint8_t head = 0; // Next byte written
+static uint8_t tail = 0; // Next byte sent
+
+static char line[128];   // Record being formatted
+static char message[160]; // reportOut line being printed
+static uint8_t messageLength = 0;
+static bool messageTooLong = false;
+static ReportFormat format = REPORT_TEXT;
+static uint8_t sequence = 0;
+static uint16_t dropped = 0;
+
+const uint8_t binarySync = 0xA5;
+
+ReportOut reportOut;
+
+static uint8_t ringFree() {
+  return 255 - (uint8_t)(head - tail);
+}
+
+static bool queue(const void *data, uint8_t length) {
+  if (length > ringFree()) {
+    dropped++;
+    return false;
+  }
+  const uint8_t *bytes = (const uint8_t *)data;
+  while (length--) ring[head++] = *bytes++;
+  return true;
+}
+
+size_t ReportOut::write(uint8_t ch) {
+  if (messageLength < sizeof(message)) {
+    message[messageLength++] = ch;
+  } else {
+    messageTooLong = true;
+  }
+  if (ch == '\n') {
+    if (messageTooLong) {
+      dropped++;
+    } else {
+      queue(message, messageLength);
+    }
+    messageLength = 0;
+    messageTooLong = false;
+  }
+  return 1;
+}
+
+// Formatting helpers: each writes at out and returns the new end
+
+static char *putText(char *out, const char *text) { // text in PROGMEM
+  size_t length = strlen_P(text);
+  memcpy_P(out, text, length);
+  return out + length;
+}
+
+static char *putUnsigned(char *out, uint32_t value) {
+  char digits[10];
+  uint8_t count = 0;
+  while (value > 0xFFFF) {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  }
+  uint16_t small = value; // 16-bit division for the rest is much cheaper
+  do {
+    digits[count++] = '0' + small % 10;
+    small /= 10;
+  } while (small != 0);
+  while (count > 0) *out++ = digits[--count];
+  return out;
+}
+
+// Tenths as a decimal, e.g. -35 as "-3.5"
+static char *putTenths(char *out, int16_t value) {
+  uint16_t magnitude = value;
+  if (value < 0) {
+    *out++ = '-';
+    magnitude = -magnitude;
+  }
+  out = putUnsigned(out, magnitude / 10);
+  *out++ = '.';
+  *out++ = '0' + magnitude % 10;
+  return out;
+}
+
+static char *putInt16(char *out, int16_t value) {
+  *out++ = value & 0xFF;
+  *out++ = (uint16_t)value >> 8;
+  return out;
+}
+
+static uint8_t textRecord(const ReportSample &s) {
+  char *out = line;
+  out = putText(out, PSTR("Humidity: "));
+  out = putTenths(out, s.humidity);
+  out = putText(out, PSTR("% | Temperatures: "));
+  out = putTenths(out, s.tempC);
+  out = putText(out, PSTR("C, "));
+  out = putTenths(out, s.tempF);
+  out = putText(out, PSTR("F, Heat Index: "));
+  out = putTenths(out, s.heatIndexC);
+  out = putText(out, PSTR("C, "));
+  out = putTenths(out, s.heatIndexF);
+  out = putText(out, PSTR("F | Max loop: "));
+  out = putUnsigned(out, s.maxLoopUs);
+  out = putText(out, PSTR(" us\r\n"));
+  return out - line;
+}
+
+static uint8_t csvRecord(const ReportSample &s) {
+  char *out = line;
+  out = putUnsigned(out, s.takenAt);
+  *out++ = ',';
+  out = putTenths(out, s.tempC);
+  *out++ = ',';
+  out = putTenths(out, s.humidity);
+  *out++ = ',';
+  out = putTenths(out, s.heatIndexC);
+  *out++ = '\r';
+  *out++ = '\n';
+  return out - line;
+}
+
+static uint8_t binaryRecord(const ReportSample &s) {
+  char *out = line;
+  *out++ = binarySync;
+  *out++ = sequence++;
+  out = putInt16(out, s.takenAt & 0xFFFF);
+  out = putInt16(out, s.takenAt >> 16);
+  out = putInt16(out, s.tempC);
+  out = putInt16(out, s.humidity);
+  uint8_t check = 0;
+  for (char *p = line + 1; p < out; p++) check ^= *p;
+  *out++ = check;
+  return out - line;
+}
+
+void reportSetFormat(ReportFormat newFormat) {
+  format = newFormat;
+  if (format == REPORT_CSV) {
+    reportOut.print(F("ms,tempC,humidity,heatIndexC\r\n"));
+  }
+}
+
+ReportFormat reportFormat() {
+  return format;
+}
+
+const __FlashStringHelper *reportFormatName(ReportFormat which) {
+  switch (which) {
+    case REPORT_CSV:    return F("csv");
+    case REPORT_BINARY: return F("binary");
+    default:            return F("text");
+  }
+}
+
+bool reportSample(const ReportSample &sample) {
+  uint8_t length;
+  switch (format) {
+    case REPORT_CSV:    length = csvRecord(sample); break;
+    case REPORT_BINARY: length = binaryRecord(sample); break;
+    default:            length = textRecord(sample); break;
+  }
+  return queue(line, length);
+}
+
+void reportPump() {
+  int room = Serial.availableForWrite();
+  while (room > 0 && tail != head) {
+    Serial.write(ring[tail++]);
+    room--;
+  }
+}
+
+uint8_t reportRoom() {
+  return ringFree();
+}
+
+uint16_t reportDropped() {
+  return dropped;
+}
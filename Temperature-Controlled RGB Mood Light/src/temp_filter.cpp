@@ -0,0 +1,68 @@
+#include "temp_filter.h"
+
+void filterReset(TempFilter &filter) {
+  filter.head = 0;
+  filter.count = 0;
+  filter.ema = 0;
+}
+
+// Median of the samples in the ring (insertion sort of at most five values)
+static int16_t ringMedian(const TempFilter &filter) {
+  int16_t sorted[filterWindow];
+  for (uint8_t i = 0; i < filter.count; i++) {
+    int16_t value = filter.ring[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > value) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = value;
+  }
+  return sorted[filter.count / 2];
+}
+
+// Add a reading and return the smoothed temperature
+int16_t filterAdd(TempFilter &filter, int16_t sample) {
+  filter.ring[filter.head] = sample;
+  filter.head = (filter.head + 1) % filterWindow;
+  if (filter.count < filterWindow) filter.count++;
+
+  int32_t median = (int32_t)ringMedian(filter) << 4;
+  if (filter.count == 1) {
+    filter.ema = median; // Start the average at the first reading
+  } else {
+    filter.ema += (median - filter.ema) / (1 << filterShift);
+  }
+  return (filter.ema + (filter.ema >= 0 ? 8 : -8)) / 16;
+}
+
+// Band for a temperature with no history
+static TempBand classify(const BandConfig &config, int16_t temp) {
+  if (temp < config.comfortFrom) return BAND_COLD;
+  if (temp < config.hotFrom) return BAND_COMFORT;
+  return BAND_HOT;
+}
+
+bool bandUpdate(TempBand *band, const BandConfig &config, int16_t temp) {
+  TempBand next = *band;
+
+  switch (*band) {
+    case BAND_COLD:
+      if (temp >= config.comfortFrom + config.hysteresis) next = classify(config, temp);
+      break;
+    case BAND_COMFORT:
+      if (temp < config.comfortFrom - config.hysteresis) next = BAND_COLD;
+      else if (temp >= config.hotFrom + config.hysteresis) next = BAND_HOT;
+      break;
+    case BAND_HOT:
+      if (temp < config.hotFrom - config.hysteresis) next = classify(config, temp);
+      break;
+    default:
+      next = classify(config, temp);
+      break;
+  }
+
+  if (next == *band) return false;
+  *band = next;
+  return true;
+}
@@ -0,0 +1,63 @@
+#include "temp_trend.h"
+
+// Fixed sums over the positions 0 .. trendWindow - 1
+const int32_t sumX = (int32_t)trendWindow * (trendWindow - 1) / 2;
+// n * sum(x^2) - sum(x)^2, the slope's denominator
+const int32_t spread = (int32_t)trendWindow * trendWindow *
+                       ((int32_t)trendWindow * trendWindow - 1) / 12;
+static_assert(spread % trendWindow == 0, "trendWindow must keep spread / n whole");
+
+void trendReset(TempTrend &trend) {
+  trend.head = 0;
+  trend.count = 0;
+  trend.sumY = 0;
+  trend.sumXY = 0;
+}
+
+void trendAdd(TempTrend &trend, int16_t temp) {
+  if (trend.count < trendWindow) {
+    trend.sumXY += (int32_t)trend.count * temp;
+    trend.count++;
+  } else {
+    // Every reading moves one position older and the oldest drops out:
+    // sum(x*y) loses sum(y) - oldest, and the new reading comes in at the end
+    int16_t oldest = trend.ring[trend.head];
+    trend.sumXY += (int32_t)(trendWindow - 1) * temp - (trend.sumY - oldest);
+    trend.sumY -= oldest;
+  }
+  trend.sumY += temp;
+  trend.ring[trend.head] = temp;
+  trend.head = (trend.head + 1) % trendWindow;
+}
+
+bool trendReady(const TempTrend &trend) {
+  return trend.count == trendWindow;
+}
+
+// Slope times spread (0.1 °C per reading)
+static int32_t slopeScaled(const TempTrend &trend) {
+  return (int32_t)trendWindow * trend.sumXY - sumX * trend.sumY;
+}
+
+int16_t trendPerMinute(const TempTrend &trend, uint16_t periodMs) {
+  if (!trendReady(trend) || periodMs == 0) return 0;
+  // Scaled to a minute before the one division, rounded to the nearest tenth
+  int32_t perMinute = slopeScaled(trend) * (60000L / periodMs);
+  return (perMinute + (perMinute >= 0 ? spread / 2 : -spread / 2)) / spread;
+}
+
+uint32_t trendTimeTo(const TempTrend &trend, int16_t threshold, uint16_t periodMs) {
+  if (!trendReady(trend)) return trendNever;
+  int32_t slope = slopeScaled(trend);
+  // Twice the fitted value at the newest reading, times spread:
+  // mean + slope * (n - 1) / 2
+  int32_t fitted = 2 * trend.sumY * (spread / trendWindow) + slope * (trendWindow - 1);
+  int32_t gap = 2 * (int32_t)threshold * spread - fitted;
+  if (gap <= 0) return 0;
+  if (slope <= 0) return trendNever;
+
+  // Readings to go, in tenths of a reading
+  uint32_t readings = (uint32_t)gap * 10 / (2 * (uint32_t)slope);
+  if (readings > trendNever / periodMs) return trendNever;
+  return readings * periodMs / 10;
+}
@@ -0,0 +1,180 @@
+// Just enough of the Arduino core to build the Mood Light modules and
+// lib/DHT on the host.
+//
+// Time only moves when a test calls hostAdvance(), or while code busy-waits:
+// every digitalRead() and delayMicroseconds() advances the clock, so polling
+// loops terminate. A test can take over the pins (a simulated sensor) by
+// setting hostPins().read, and sees pin mode and level changes through
+// hostPins().changed. Registers are plain variables; ISR() defines a function
+// the test can call.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#define F_CPU 16000000UL
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define _BV(bit) (1 << (bit))
+#define clockCyclesPerMicrosecond() (F_CPU / 1000000L)
+#define clockCyclesToMicroseconds(a) ((a) / clockCyclesPerMicrosecond())
+
+// Flash is ordinary memory here
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+#define memcpy_P memcpy
+#define strlen_P strlen
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+
+// Clock
+
+inline unsigned long &hostMicros() {
+  static unsigned long now = 0;
+  return now;
+}
+inline void hostAdvance(unsigned long us) { hostMicros() += us; }
+inline unsigned long micros() { return hostMicros(); }
+inline unsigned long millis() { return hostMicros() / 1000; }
+inline void delayMicroseconds(unsigned int us) { hostAdvance(us); }
+
+// Registers
+
+#define HOST_REGISTER(type, name) \
+  inline volatile type &host_##name() { static volatile type reg = 0; return reg; }
+HOST_REGISTER(uint8_t, SREG)
+HOST_REGISTER(uint8_t, TCCR5A)
+HOST_REGISTER(uint8_t, TCCR5B)
+HOST_REGISTER(uint8_t, TIMSK5)
+HOST_REGISTER(uint8_t, TIFR5)
+HOST_REGISTER(uint16_t, TCNT5)
+HOST_REGISTER(uint16_t, OCR5A)
+HOST_REGISTER(uint16_t, OCR5B)
+HOST_REGISTER(uint8_t, PORT_INPUT)
+#define SREG host_SREG()
+#define TCCR5A host_TCCR5A()
+#define TCCR5B host_TCCR5B()
+#define TIMSK5 host_TIMSK5()
+#define TIFR5 host_TIFR5()
+#define TCNT5 host_TCNT5()
+#define OCR5A host_OCR5A()
+#define OCR5B host_OCR5B()
+#define CS50 0
+#define CS51 1
+#define OCIE5A 1
+#define OCIE5B 2
+#define OCF5A 1
+#define OCF5B 2
+
+#define ISR(vector, ...) extern "C" void vector(void)
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// Pins
+
+struct HostPins {
+  uint8_t mode[80];
+  uint8_t level[80];                    // Output latch
+  int (*read)(uint8_t pin);             // Input level, if a test drives the pin
+  void (*changed)(uint8_t pin);         // Mode or latch changed
+};
+inline HostPins &hostPins() {
+  static HostPins pins;
+  return pins;
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  hostPins().mode[pin] = mode;
+  if (hostPins().changed) hostPins().changed(pin);
+}
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+  hostPins().level[pin] = value;
+  if (hostPins().changed) hostPins().changed(pin);
+}
+inline int digitalRead(uint8_t pin) {
+  hostAdvance(1);
+  if (hostPins().read) return hostPins().read(pin);
+  return hostPins().level[pin];
+}
+#define digitalPinToBitMask(pin) ((uint8_t)1)
+#define digitalPinToPort(pin) ((uint8_t)(pin))
+#define portInputRegister(port) (&host_PORT_INPUT())
+
+// Serial: what is printed collects in `sent`; availableForWrite() reports
+// `room`, which a test sets to model a busy UART.
+
+class Print {
+public:
+  virtual size_t write(uint8_t ch) = 0;
+  size_t write(const char *text) {
+    size_t n = 0;
+    while (*text) n += write((uint8_t)*text++);
+    return n;
+  }
+  size_t print(const __FlashStringHelper *text) { return write((const char *)text); }
+  size_t print(const char *text) { return write(text); }
+  size_t print(char ch) { return write((uint8_t)ch); }
+  size_t print(long value) { return number("%ld", value); }
+  size_t print(int value) { return number("%ld", value); }
+  size_t print(unsigned long value) { return unumber(value); }
+  size_t print(unsigned int value) { return unumber(value); }
+  size_t print(unsigned char value) { return unumber(value); }
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T value) { return print(value) + println(); }
+
+private:
+  size_t number(const char *format, long value) {
+    char text[24];
+    snprintf(text, sizeof(text), format, value);
+    return write(text);
+  }
+  size_t unumber(unsigned long value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%lu", value);
+    return write(text);
+  }
+};
+
+class HostSerial : public Print {
+public:
+  std::string sent;
+  int room = 63;
+  size_t write(uint8_t ch) override {
+    sent += (char)ch;
+    if (room > 0) room--;
+    return 1;
+  }
+  using Print::write;
+  int availableForWrite() { return room; }
+  int available() { return 0; }
+  int read() { return -1; }
+};
+inline HostSerial &hostSerial() {
+  static HostSerial serial;
+  return serial;
+}
+#define Serial hostSerial()
+
+#endif
@@ -0,0 +1,121 @@
+// A simulated DHT sensor on a host pin, for the tests that run lib/DHT
+// through its blocking read.
+//
+// The sensor answers the end of a start signal (the pin driven low, then
+// high) 30 us later with the usual reply: 80 us low, 80 us high, then 40
+// bits of 50 us low and a high pulse of zero_us or one_us. It stays quiet
+// if `respond` is false, and goes quiet after `bits` bits, which the host
+// sees as a frame error. Every start signal is counted and timestamped.
+#ifndef DHT_SIM_H
+#define DHT_SIM_H
+
+#include <Arduino.h>
+
+struct DhtSim {
+  uint8_t pin;
+  uint8_t frame[5];
+  bool respond = true;
+  uint8_t bits = 40;
+  uint8_t zero_us = 26;
+  uint8_t one_us = 70;
+
+  uint16_t starts = 0;            // Start signals seen
+  unsigned long last_start = 0;   // micros() when the last one ended
+  bool driven_low = false;
+  bool playing = false;
+
+  explicit DhtSim(uint8_t pin) : pin(pin) { set(0, 0, 0, 0); }
+
+  // Load a frame and give it a good checksum
+  void set(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3) {
+    frame[0] = b0;
+    frame[1] = b1;
+    frame[2] = b2;
+    frame[3] = b3;
+    frame[4] = (uint8_t)(b0 + b1 + b2 + b3);
+  }
+
+  void changed() {
+    const HostPins &pins = hostPins();
+    if (pins.mode[pin] == OUTPUT && pins.level[pin] == LOW) {
+      driven_low = true;
+      playing = false;
+    } else if (driven_low && pins.level[pin] == HIGH) {
+      driven_low = false;
+      playing = true;
+      starts++;
+      last_start = micros();
+    }
+  }
+
+  int level() {
+    if (!playing || !respond) return HIGH;
+    unsigned long t = micros() - last_start;
+    if (t < 30) return HIGH;
+    t -= 30;
+    if (t < 80) return LOW;
+    t -= 80;
+    if (t < 80) return HIGH;
+    t -= 80;
+    for (uint8_t i = 0; i < 40; i++) {
+      if (i >= bits) return HIGH;
+      if (t < 50) return LOW;
+      t -= 50;
+      uint8_t width = (frame[i / 8] & (0x80 >> (i % 8))) ? one_us : zero_us;
+      if (t < width) return HIGH;
+      t -= width;
+    }
+    if (t < 50) return LOW;
+    playing = false;
+    return HIGH;
+  }
+};
+
+// Route the host pins to the simulated sensors
+inline DhtSim *(&dhtSims())[8] {
+  static DhtSim *sims[8];
+  return sims;
+}
+inline DhtSim *dhtSimOn(uint8_t pin) {
+  for (DhtSim *sim : dhtSims())
+    if (sim && sim->pin == pin) return sim;
+  return NULL;
+}
+inline void dhtSimChanged(uint8_t pin) {
+  if (DhtSim *sim = dhtSimOn(pin)) sim->changed();
+}
+inline int dhtSimRead(uint8_t pin) {
+  DhtSim *sim = dhtSimOn(pin);
+  return sim ? sim->level() : hostPins().level[pin];
+}
+inline void dhtSimAttach(DhtSim &sim) {
+  for (DhtSim *&slot : dhtSims()) {
+    if (slot == NULL || slot == &sim) {
+      slot = &sim;
+      break;
+    }
+  }
+  hostPins().changed = dhtSimChanged;
+  hostPins().read = dhtSimRead;
+}
+inline void dhtSimDetachAll() {
+  for (DhtSim *&slot : dhtSims()) slot = NULL;
+  hostPins().changed = NULL;
+  hostPins().read = NULL;
+}
+
+// Poll measure() once a millisecond until the read that is in progress, or
+// the next one, has finished. Returns what the final measure() returned.
+template <typename Sensor>
+bool dhtReadOnce(Sensor &dht, int16_t *temperature, int16_t *humidity) {
+  bool started = false;
+  for (long ms = 0; ms < 10000; ms++) {
+    if (dht.measure(temperature, humidity)) return true;
+    if (dht.is_measuring()) started = true;
+    else if (started) return false;
+    hostAdvance(1000);
+  }
+  return false;
+}
+
+#endif
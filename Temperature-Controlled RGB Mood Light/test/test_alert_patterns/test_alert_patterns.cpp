@@ -0,0 +1,148 @@
+// Alert patterns on a virtual Timer5: the test moves TCNT5 on to the next
+// enabled compare match and calls its interrupt handler, and records when
+// each channel's output switches. Every edge must land exactly on the
+// pattern's schedule, in 4 us ticks.
+#include <unity.h>
+#include <Arduino.h>
+#include <alert_patterns.h>
+
+extern "C" void TIMER5_COMPA_vect(void);
+extern "C" void TIMER5_COMPB_vect(void);
+
+static const uint32_t ticksPerMs = 250;
+
+// The sketch's patterns
+static const AlertPattern beep PROGMEM = {200, 400, 3, 3200, 0};
+static const AlertPattern flash PROGMEM = {200, 200, 1, 0, 0};
+static const AlertPattern chirp PROGMEM = {50, 0, 1, 9950, 0};
+
+struct Edge {
+  uint32_t atMs;
+  bool on;
+};
+
+struct Recorder {
+  Edge edges[64];
+  uint8_t count;
+  bool on;
+};
+
+static Recorder recorders[ALERT_CHANNELS];
+static uint32_t ticks; // Timer5 ticks since the test started, unwrapped
+
+static void record(uint8_t channel, bool on) {
+  Recorder &recorder = recorders[channel];
+  recorder.on = on;
+  TEST_ASSERT_EQUAL_UINT32(0, ticks % ticksPerMs);
+  if (recorder.count < 64) recorder.edges[recorder.count++] = {ticks / ticksPerMs, on};
+}
+static void buzzer(bool on) { record(ALERT_BUZZER, on); }
+static void led(bool on) { record(ALERT_LED, on); }
+
+// Run the timer for ms, servicing the compare matches as they come up
+static void runFor(uint32_t ms) {
+  uint32_t end = ticks + ms * ticksPerMs;
+  while (ticks < end) {
+    uint32_t untilA = (TIMSK5 & _BV(OCIE5A)) ? (uint16_t)(OCR5A - TCNT5) : 0x10000;
+    uint32_t untilB = (TIMSK5 & _BV(OCIE5B)) ? (uint16_t)(OCR5B - TCNT5) : 0x10000;
+    if (untilA == 0) untilA = 0x10000;
+    if (untilB == 0) untilB = 0x10000;
+    uint32_t step = untilA < untilB ? untilA : untilB;
+    if (step > end - ticks) step = end - ticks;
+    ticks += step;
+    TCNT5 = TCNT5 + step;
+    if (step == untilA) TIMER5_COMPA_vect();
+    if (step == untilB) TIMER5_COMPB_vect();
+  }
+}
+
+static void checkEdges(uint8_t channel, const uint32_t *expected, uint8_t count) {
+  const Recorder &recorder = recorders[channel];
+  TEST_ASSERT_GREATER_OR_EQUAL(count, recorder.count);
+  for (uint8_t i = 0; i < count; i++) {
+    TEST_ASSERT_EQUAL_UINT32(expected[i], recorder.edges[i].atMs);
+    TEST_ASSERT_EQUAL(i % 2 == 0, recorder.edges[i].on);
+  }
+}
+
+void setUp(void) {
+  memset(recorders, 0, sizeof(recorders));
+  alertBegin(buzzer, led);
+  alertCancel(ALERT_BUZZER, 255);
+  alertCancel(ALERT_LED, 255);
+  memset(recorders, 0, sizeof(recorders));
+  ticks = 0;
+  TCNT5 = 0xF000; // Close to the wrap
+}
+
+void tearDown(void) {}
+
+// Three 200 ms beeps 600 ms apart, a burst every 5 s; the LED flashes
+// 200/200 alongside on the other compare unit
+void test_temperature_alert(void) {
+  TEST_ASSERT_TRUE(alertPlay(ALERT_BUZZER, &beep, 1));
+  TEST_ASSERT_TRUE(alertPlay(ALERT_LED, &flash, 1));
+  runFor(10500);
+
+  static const uint32_t beeps[] = {0, 200, 600, 800, 1200, 1400,
+                                   5000, 5200, 5600, 5800, 6200, 6400, 10000, 10200};
+  checkEdges(ALERT_BUZZER, beeps, 14);
+  uint32_t flashes[52];
+  for (uint8_t i = 0; i < 52; i++) flashes[i] = i * 200;
+  checkEdges(ALERT_LED, flashes, 52);
+  TEST_ASSERT_TRUE(alertPlaying(ALERT_BUZZER));
+}
+
+// Phases much longer than one turn of the 16-bit timer are split up and
+// still end on the tick
+void test_long_pause(void) {
+  TEST_ASSERT_TRUE(alertPlay(ALERT_BUZZER, &chirp, 0));
+  runFor(30100);
+  static const uint32_t chirps[] = {0, 50, 10000, 10050, 20000, 20050, 30000, 30050};
+  checkEdges(ALERT_BUZZER, chirps, 8);
+}
+
+// A pattern with a cycle count stops by itself, with its output off
+void test_cycles_finish(void) {
+  static const AlertPattern twice PROGMEM = {100, 100, 2, 500, 2};
+  TEST_ASSERT_TRUE(alertPlay(ALERT_BUZZER, &twice, 0));
+  runFor(3000);
+  static const uint32_t edges[] = {0, 100, 200, 300, 900, 1000, 1100, 1200};
+  checkEdges(ALERT_BUZZER, edges, 8);
+  TEST_ASSERT_EQUAL_UINT8(8, recorders[ALERT_BUZZER].count);
+  TEST_ASSERT_FALSE(alertPlaying(ALERT_BUZZER));
+  TEST_ASSERT_FALSE(TIMSK5 & _BV(OCIE5A));
+}
+
+// Lower priority can't replace or cancel a pattern; equal or higher can
+void test_priority(void) {
+  TEST_ASSERT_TRUE(alertPlay(ALERT_BUZZER, &beep, 1));
+  runFor(100);
+  TEST_ASSERT_FALSE(alertPlay(ALERT_BUZZER, &chirp, 0));
+  alertCancel(ALERT_BUZZER, 0);
+  TEST_ASSERT_TRUE(alertPlaying(ALERT_BUZZER));
+
+  // The chirp takes over from where the beep was, with its own timing
+  TEST_ASSERT_TRUE(alertPlay(ALERT_BUZZER, &chirp, 1));
+  runFor(200);
+  const Recorder &recorder = recorders[ALERT_BUZZER];
+  TEST_ASSERT_EQUAL_UINT8(3, recorder.count);
+  TEST_ASSERT_EQUAL_UINT32(100, recorder.edges[1].atMs);
+  TEST_ASSERT_TRUE(recorder.edges[1].on);
+  TEST_ASSERT_EQUAL_UINT32(150, recorder.edges[2].atMs);
+  TEST_ASSERT_FALSE(recorder.edges[2].on);
+
+  alertCancel(ALERT_BUZZER, 1);
+  TEST_ASSERT_FALSE(alertPlaying(ALERT_BUZZER));
+  TEST_ASSERT_FALSE(recorders[ALERT_BUZZER].on);
+  TEST_ASSERT_FALSE(TIMSK5 & _BV(OCIE5A));
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_temperature_alert);
+  RUN_TEST(test_long_pause);
+  RUN_TEST(test_cycles_finish);
+  RUN_TEST(test_priority);
+  return UNITY_END();
+}
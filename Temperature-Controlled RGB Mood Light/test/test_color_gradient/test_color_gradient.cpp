@@ -0,0 +1,143 @@
+// The temperature gradient swept from 0 to 50 C in 0.1 C steps: within each
+// segment every channel must move one way only, no step may jump by more
+// than the segment's slope allows, and the ends and stops must land exactly
+// on the table's colours. The fade must always reach its target.
+#include <unity.h>
+#include <Arduino.h>
+#include <color_gradient.h>
+
+// The table in color_gradient.cpp: blue, cyan, green, yellow, red
+static const uint8_t stops = 5;
+static const RGB stopColors[stops] = {
+  {0, 0, 255}, {0, 255, 255}, {0, 255, 0}, {255, 255, 0}, {255, 0, 0},
+};
+
+static uint32_t seed;
+
+static uint32_t nextRandom() {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+static void expectColor(const RGB &expected, const RGB &actual) {
+  TEST_ASSERT_EQUAL_UINT8(expected.r, actual.r);
+  TEST_ASSERT_EQUAL_UINT8(expected.g, actual.g);
+  TEST_ASSERT_EQUAL_UINT8(expected.b, actual.b);
+}
+
+static int channel(const RGB &color, uint8_t c) {
+  return c == 0 ? color.r : c == 1 ? color.g : color.b;
+}
+
+// Sweeps the current range; returns the largest step of any channel
+static int sweep() {
+  int16_t cold = gradientColdC(), hot = gradientHotC();
+  int span = hot - cold;
+  // 255 over a quarter of the span, plus one for rounding either side
+  int bound = (255 * (stops - 1) + span - 1) / span + 1;
+  int worst = 0;
+  RGB previous = gradientTarget(0);
+  for (int16_t temp = 1; temp <= 500; temp++) {
+    RGB color = gradientTarget(temp);
+    int32_t offset = temp - cold;
+    if (temp <= cold) expectColor(stopColors[0], color);
+    if (temp >= hot) expectColor(stopColors[stops - 1], color);
+    // A stop exactly on a tenth of a degree shows its colour
+    if (offset >= 0 && offset <= span && offset * (stops - 1) % span == 0) {
+      expectColor(stopColors[offset * (stops - 1) / span], color);
+    }
+
+    // Each channel heads from the colour of one stop toward the next, so a
+    // step may only move it the ways the segments it spans do
+    int32_t from = offset - 1, to = offset;
+    if (from < 0) from = 0;
+    if (to > span) to = span;
+    uint8_t first = from * (stops - 1) / span, last = to > 0 ? (to * (stops - 1) - 1) / span : 0;
+    if (first > stops - 2) first = stops - 2;
+    for (uint8_t c = 0; c < 3; c++) {
+      int step = channel(color, c) - channel(previous, c);
+      bool up = false, down = false;
+      for (uint8_t segment = first; segment <= last && to > from; segment++) {
+        int direction = channel(stopColors[segment + 1], c) - channel(stopColors[segment], c);
+        up = up || direction > 0;
+        down = down || direction < 0;
+      }
+      if (!up) TEST_ASSERT_LESS_OR_EQUAL(0, step);
+      if (!down) TEST_ASSERT_GREATER_OR_EQUAL(0, step);
+      TEST_ASSERT_LESS_OR_EQUAL(bound, abs(step));
+      if (abs(step) > worst) worst = abs(step);
+    }
+    previous = color;
+  }
+  return worst;
+}
+
+void setUp(void) { gradientSetRange(150, 350); }
+void tearDown(void) {}
+
+void test_default_range(void) {
+  TEST_ASSERT_EQUAL_INT16(150, gradientColdC());
+  TEST_ASSERT_EQUAL_INT16(350, gradientHotC());
+  int worst = sweep();
+  char message[64];
+  snprintf(message, sizeof(message), "15-35 C: largest step %d per 0.1 C", worst);
+  TEST_MESSAGE(message);
+}
+
+// A narrow range with stops 2 C apart, and an odd one whose stops fall
+// between tenths
+void test_custom_ranges(void) {
+  TEST_ASSERT_TRUE(gradientSetRange(180, 260));
+  int narrow = sweep();
+  TEST_ASSERT_TRUE(gradientSetRange(-53, 417));
+  int odd = sweep();
+  char message[80];
+  snprintf(message, sizeof(message), "18-26 C: largest step %d, -5.3-41.7 C: %d", narrow, odd);
+  TEST_MESSAGE(message);
+}
+
+void test_bad_range_kept_out(void) {
+  TEST_ASSERT_FALSE(gradientSetRange(300, 300));
+  TEST_ASSERT_FALSE(gradientSetRange(300, 200));
+  TEST_ASSERT_EQUAL_INT16(150, gradientColdC());
+  TEST_ASSERT_EQUAL_INT16(350, gradientHotC());
+}
+
+// From random colours to random targets: every step moves each channel
+// toward its target without passing it, and the fade ends on it
+void test_step_reaches_target(void) {
+  seed = 41;
+  int longest = 0;
+  for (int n = 0; n < 10000; n++) {
+    RGB shown = {(uint8_t)nextRandom(), (uint8_t)nextRandom(), (uint8_t)nextRandom()};
+    RGB target = gradientTarget(nextRandom() % 501);
+    int steps = 0;
+    while (true) {
+      RGB before = shown;
+      if (!gradientStep(shown, target)) break;
+      steps++;
+      TEST_ASSERT_LESS_OR_EQUAL(64, steps);
+      for (uint8_t c = 0; c < 3; c++) {
+        int was = abs(channel(before, c) - channel(target, c));
+        int now = abs(channel(shown, c) - channel(target, c));
+        TEST_ASSERT_TRUE(now < was || was == 0);
+        TEST_ASSERT_TRUE((channel(shown, c) - channel(target, c)) *
+                         (channel(before, c) - channel(target, c)) >= 0);
+      }
+    }
+    expectColor(target, shown);
+    if (steps > longest) longest = steps;
+  }
+  char message[48];
+  snprintf(message, sizeof(message), "longest fade %d steps", longest);
+  TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_default_range);
+  RUN_TEST(test_custom_ranges);
+  RUN_TEST(test_bad_range_kept_out);
+  RUN_TEST(test_step_reaches_target);
+  return UNITY_END();
+}
@@ -0,0 +1,88 @@
+// The fixed-point heat index and dew point against the same formulas in
+// floating point, over every 0.1 step of -40 to 80 C and 0 to 100 %. The
+// fixed-point results are rounded to 0.1 C, which accounts for 0.05 C of the
+// 0.075 C allowed.
+#include <unity.h>
+#include <dht_nonblocking.h>
+
+// Adafruit's computeHeatIndex(), in Celsius
+template <typename Real>
+static Real heatIndex(Real celsius, Real humidity) {
+  Real t = celsius * Real(1.8) + 32;
+  Real hi = Real(0.5) * (t + Real(61.0) + ((t - Real(68.0)) * Real(1.2)) + (humidity * Real(0.094)));
+  if (hi > 79) {
+    hi = Real(-42.379) + Real(2.04901523) * t + Real(10.14333127) * humidity +
+         Real(-0.22475541) * t * humidity + Real(-0.00683783) * t * t +
+         Real(-0.05481717) * humidity * humidity + Real(0.00122874) * t * t * humidity +
+         Real(0.00085282) * t * humidity * humidity +
+         Real(-0.00000199) * t * t * humidity * humidity;
+    if ((humidity < 13) && (t >= Real(80.0)) && (t <= Real(112.0)))
+      hi -= ((Real(13.0) - humidity) * Real(0.25)) * sqrt((Real(17.0) - fabs(t - Real(95.0))) * Real(0.05882));
+    else if ((humidity > Real(85.0)) && (t >= Real(80.0)) && (t <= Real(87.0)))
+      hi += ((humidity - Real(85.0)) * Real(0.1)) * ((Real(87.0) - t) * Real(0.2));
+  }
+  return (hi - 32) / Real(1.8);
+}
+
+// Magnus, b = 17.62, c = 243.12 C
+static double dewPoint(double celsius, double humidity) {
+  if (humidity < 0.1) humidity = 0.1;
+  double gamma = log(humidity / 100) + 17.62 * celsius / (243.12 + celsius);
+  return 243.12 * gamma / (17.62 - gamma);
+}
+
+struct Worst {
+  double error;
+  int16_t temperature, humidity;
+};
+
+static void check(Worst &worst, double error, int16_t temperature, int16_t humidity) {
+  error = fabs(error);
+  if (error > worst.error) worst = {error, temperature, humidity};
+}
+
+static void report(const char *name, const Worst &worst) {
+  char message[96];
+  snprintf(message, sizeof(message), "%s: worst error %.3f C at %.1f C, %.1f %%", name,
+           worst.error, worst.temperature / 10.0, worst.humidity / 10.0);
+  TEST_MESSAGE(message);
+}
+
+void test_heat_index(void) {
+  Worst exact = {}, single = {};
+  for (int16_t temperature = -400; temperature <= 800; temperature++) {
+    for (int16_t humidity = 0; humidity <= 1000; humidity++) {
+      double fixed = dht_heat_index(temperature, humidity) / 10.0;
+      check(exact, fixed - heatIndex<double>(temperature / 10.0, humidity / 10.0),
+            temperature, humidity);
+      check(single, fixed - heatIndex<float>(temperature / 10.0f, humidity / 10.0f),
+            temperature, humidity);
+    }
+  }
+  report("heat index against double", exact);
+  report("heat index against float", single);
+  TEST_ASSERT_LESS_OR_EQUAL(75, (int)(exact.error * 1000));
+  TEST_ASSERT_LESS_OR_EQUAL(75, (int)(single.error * 1000));
+}
+
+void test_dew_point(void) {
+  Worst worst = {};
+  for (int16_t temperature = -400; temperature <= 800; temperature++) {
+    for (int16_t humidity = 1; humidity <= 1000; humidity++) {
+      double fixed = dht_dew_point(temperature, humidity) / 10.0;
+      check(worst, fixed - dewPoint(temperature / 10.0, humidity / 10.0), temperature, humidity);
+    }
+  }
+  report("dew point against double", worst);
+  TEST_ASSERT_LESS_OR_EQUAL(75, (int)(worst.error * 1000));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_heat_index);
+  RUN_TEST(test_dew_point);
+  return UNITY_END();
+}
@@ -0,0 +1,136 @@
+// DHT_bus with four simulated DHT22s, polled once a millisecond: each
+// sensor starts in its own slot, a quarter period after the one before, bad
+// frames are retried early, and no two measurements ever overlap.
+#include <unity.h>
+#include <dht_bus.h>
+#include <dht_sim.h>
+
+static const uint8_t sensorCount = 4;
+static const uint8_t pins[sensorCount] = {2, 3, 4, 5};
+
+static DhtSim sims[sensorCount] = {DhtSim(2), DhtSim(3), DhtSim(4), DhtSim(5)};
+
+void setUp(void) {
+  hostMicros() = 0;
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    sims[i] = DhtSim(pins[i]);
+    sims[i].set(0x02, 0x8C, 0x00, 0xE0 + i);
+    dhtSimAttach(sims[i]);
+  }
+}
+
+void tearDown(void) { dhtSimDetachAll(); }
+
+void test_staggered_slots(void) {
+  DHT_nonblocking a(pins[0], DHT_TYPE_22), b(pins[1], DHT_TYPE_22),
+      c(pins[2], DHT_TYPE_22), d(pins[3], DHT_TYPE_22);
+  DHT_nonblocking *const sensors[sensorCount] = {&a, &b, &c, &d};
+  DHT_bus bus(sensors, sensorCount);
+  TEST_ASSERT_EQUAL_UINT16(2000 + DHT_BUS_MARGIN, bus.period());
+  const unsigned long slot = bus.period() / sensorCount;
+
+  uint16_t starts[sensorCount] = {};
+  unsigned long lastStart = 0;
+  uint8_t lastSensor = sensorCount - 1;
+  bool lastWasFirst = true;
+  unsigned long worstGap = 0, bestGap = 0xFFFFFFFF;
+  const unsigned long seconds = 60;
+  for (unsigned long ms = 0; ms < seconds * 1000; ms++) {
+    bus.poll();
+    uint8_t measuring = 0;
+    for (uint8_t i = 0; i < sensorCount; i++) {
+      if (sensors[i]->is_measuring()) measuring++;
+      if (sims[i].starts == starts[i]) continue;
+      starts[i] = sims[i].starts;
+      // Round robin, one slot apart. The first start of each sensor comes
+      // after a 250 ms release that later ones skip.
+      TEST_ASSERT_EQUAL_UINT8((lastSensor + 1) % sensorCount, i);
+      bool first = starts[i] == 1;
+      if (!first && !lastWasFirst) {
+        unsigned long gap = (sims[i].last_start - lastStart) / 1000;
+        if (gap > worstGap) worstGap = gap;
+        if (gap < bestGap) bestGap = gap;
+      }
+      lastStart = sims[i].last_start;
+      lastSensor = i;
+      lastWasFirst = first;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(1, measuring);
+    hostAdvance(1000 - hostMicros() % 1000);
+  }
+
+  char message[96];
+  snprintf(message, sizeof(message),
+           "slots %lu-%lu ms apart, %u readings in %lu s, longest poll %lu us",
+           bestGap, worstGap, (unsigned)bus.readings(), seconds,
+           bus.longest_poll_us());
+  TEST_MESSAGE(message);
+  TEST_ASSERT_UINT_WITHIN(2, slot, bestGap);
+  TEST_ASSERT_UINT_WITHIN(2, slot, worstGap);
+  // A reading for every slot started, about 1.7 a second
+  TEST_ASSERT_UINT_WITHIN(1, seconds * 1000 / slot + 1, bus.readings());
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    TEST_ASSERT_TRUE(bus.latest(i).valid);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 22.4 + i / 10.0, bus.latest(i).temperature);
+  }
+}
+
+// A bad frame is retried 250 ms later, twice at most, between the other
+// sensors' measurements; a sensor that doesn't answer waits for its slot.
+// Nothing ever overlaps.
+void test_retries(void) {
+  DHT_nonblocking a(pins[0], DHT_TYPE_22), b(pins[1], DHT_TYPE_22),
+      c(pins[2], DHT_TYPE_22), d(pins[3], DHT_TYPE_22);
+  DHT_nonblocking *const sensors[sensorCount] = {&a, &b, &c, &d};
+  DHT_bus bus(sensors, sensorCount);
+  sims[1].frame[4] ^= 1;
+  sims[2].respond = false;
+
+  unsigned long starts[2][12];
+  uint8_t count[2] = {};
+  for (unsigned long ms = 0; ms < 12000; ms++) {
+    bus.poll();
+    uint8_t measuring = 0;
+    for (uint8_t i = 0; i < sensorCount; i++) {
+      if (sensors[i]->is_measuring()) measuring++;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(1, measuring);
+    for (uint8_t i = 1; i <= 2; i++) {
+      if (sims[i].starts > count[i - 1] && count[i - 1] < 12) {
+        starts[i - 1][count[i - 1]++] = sims[i].last_start / 1000;
+      }
+    }
+    hostAdvance(1000 - hostMicros() % 1000);
+  }
+
+  // Checksum errors: a read, two retries a little over 250 ms apart (the
+  // first round's 250 ms releases can hold one back), then the full 2 s
+  // interval after the last retry
+  TEST_ASSERT_GREATER_OR_EQUAL(7, count[0]);
+  for (uint8_t n = 1; n < count[0]; n++) {
+    unsigned long gap = starts[0][n] - starts[0][n - 1];
+    if (n % 3 == 0) {
+      TEST_ASSERT_UINT_WITHIN(10, b.min_interval(), gap);
+    } else {
+      TEST_ASSERT_GREATER_OR_EQUAL(250, gap);
+      TEST_ASSERT_LESS_OR_EQUAL(250 + 80, gap);
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT16(sims[1].starts, b.stats().checksum_errors);
+
+  // No response: only in its own slot
+  TEST_ASSERT_GREATER_OR_EQUAL(4, count[1]);
+  for (uint8_t n = 2; n < count[1]; n++) {
+    TEST_ASSERT_UINT_WITHIN(1, bus.period(), starts[1][n] - starts[1][n - 1]);
+  }
+  TEST_ASSERT_TRUE(bus.latest(0).valid);
+  TEST_ASSERT_FALSE(bus.latest(1).valid);
+  TEST_ASSERT_FALSE(bus.latest(2).valid);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_staggered_slots);
+  RUN_TEST(test_retries);
+  return UNITY_END();
+}
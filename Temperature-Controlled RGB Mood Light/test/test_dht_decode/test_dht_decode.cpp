@@ -0,0 +1,185 @@
+// Frames from a simulated sensor decoded by DHT_nonblocking and by
+// DHT_static, for each sensor type. The two must agree on every frame. Also
+// the errors: a bad checksum, and a frame cut short; and the pulse timing:
+// the bit threshold and the timeout.
+#include <unity.h>
+#include <dht_nonblocking.h>
+#include <dht_static.h>
+#include <dht_sim.h>
+
+static const uint8_t dhtPin = 7;
+
+struct Frame {
+  uint8_t bytes[4];
+  int16_t temperature, humidity;  // Expected, in tenths
+};
+
+// DHT11: whole degrees and percent in bytes 2 and 0
+static const Frame dht11Frames[] = {
+  {{45, 0, 23, 0}, 230, 450},
+  {{90, 0, 0, 0}, 0, 900},
+  {{20, 0, 50, 0}, 500, 200},
+};
+
+// DHT21 and DHT22: 16-bit tenths, temperature sign in the top bit
+static const Frame dht22Frames[] = {
+  {{0x02, 0x8C, 0x01, 0x5F}, 351, 652},
+  {{0x02, 0x8C, 0x80, 0x65}, -101, 652},
+  {{0x03, 0xE8, 0x00, 0x00}, 0, 1000},
+  {{0x00, 0x00, 0x81, 0x90}, -400, 0},
+  {{0x01, 0x2C, 0x03, 0x20}, 800, 300},
+};
+
+static DhtSim sensor(dhtPin);
+
+void setUp(void) {
+  hostMicros() = 0;
+  sensor = DhtSim(dhtPin);
+  dhtSimAttach(sensor);
+}
+
+void tearDown(void) { dhtSimDetachAll(); }
+
+template <typename Sensor>
+static void checkFrames(Sensor &dht, const Frame *frames, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const Frame &frame = frames[i];
+    sensor.set(frame.bytes[0], frame.bytes[1], frame.bytes[2], frame.bytes[3]);
+    int16_t temperature = 0, humidity = 0;
+    TEST_ASSERT_TRUE(dhtReadOnce(dht, &temperature, &humidity));
+    TEST_ASSERT_EQUAL_INT16(frame.temperature, temperature);
+    TEST_ASSERT_EQUAL_INT16(frame.humidity, humidity);
+
+    float temperatureC, humidityPct;
+    while (!dht.is_idle()) {
+      hostAdvance(1000);
+      dht.measure(&temperature, &humidity);
+    }
+    while (!dht.measure(&temperatureC, &humidityPct)) hostAdvance(1000);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, frame.temperature / 10.0, temperatureC);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, frame.humidity / 10.0, humidityPct);
+  }
+  TEST_ASSERT_EQUAL_UINT16(2 * count, dht.stats().ok);
+}
+
+void test_dht11_decode(void) {
+  DHT_nonblocking dynamic(dhtPin, DHT_TYPE_11);
+  checkFrames(dynamic, dht11Frames, 3);
+  DHT_static<dhtPin, DHT_TYPE_11> fixed;
+  checkFrames(fixed, dht11Frames, 3);
+}
+
+void test_dht21_decode(void) {
+  DHT_nonblocking dynamic(dhtPin, DHT_TYPE_21);
+  checkFrames(dynamic, dht22Frames, 5);
+  DHT_static<dhtPin, DHT_TYPE_21> fixed;
+  checkFrames(fixed, dht22Frames, 5);
+}
+
+void test_dht22_decode(void) {
+  DHT_nonblocking dynamic(dhtPin, DHT_TYPE_22);
+  checkFrames(dynamic, dht22Frames, 5);
+  DHT_static<dhtPin, DHT_TYPE_22> fixed;
+  checkFrames(fixed, dht22Frames, 5);
+}
+
+// A bad checksum is reported as such and yields no reading
+void test_checksum_error(void) {
+  DHT_static<dhtPin, DHT_TYPE_22> dht;
+  sensor.set(0x02, 0x8C, 0x01, 0x5F);
+  sensor.frame[4] ^= 1;
+  int16_t temperature = 0, humidity = 0;
+  TEST_ASSERT_FALSE(dhtReadOnce(dht, &temperature, &humidity));
+  TEST_ASSERT_EQUAL_UINT16(1, dht.stats().checksum_errors);
+  TEST_ASSERT_EQUAL_UINT8(DHT_ERROR_CHECKSUM, dht.stats().last_error);
+  TEST_ASSERT_EQUAL_UINT16(0, dht.stats().ok);
+}
+
+// The blocking read reports how long it kept interrupts off: the 50 us
+// hand-over, the 60 us left of the response low and 80 us high, and 40 bits
+// of 50 us low plus their high pulses.
+void test_masked_window(void) {
+  DHT_nonblocking dht(dhtPin, DHT_TYPE_22);
+  sensor.set(0x02, 0x8C, 0x01, 0x5F);
+  unsigned long highs = 0;
+  for (uint8_t i = 0; i < 40; i++)
+    highs += (sensor.frame[i / 8] & (0x80 >> (i % 8))) ? sensor.one_us : sensor.zero_us;
+  int16_t temperature, humidity;
+  TEST_ASSERT_TRUE(dhtReadOnce(dht, &temperature, &humidity));
+  TEST_ASSERT_UINT_WITHIN(45, 50 + 60 + 80 + 40 * 50 + highs, dht.stats().masked_max);
+
+  // A sensor that never answers holds interrupts off for the 1 ms response
+  // timeout, less than a frame, so the longest window stays the frame
+  sensor.respond = false;
+  while (!dht.is_idle()) {
+    hostAdvance(1000);
+    dht.measure(&temperature, &humidity);
+  }
+  TEST_ASSERT_FALSE(dhtReadOnce(dht, &temperature, &humidity));
+  TEST_ASSERT_EQUAL_UINT8(DHT_ERROR_RESPONSE_HIGH, dht.stats().last_error);
+  TEST_ASSERT_UINT_WITHIN(45, 50 + 60 + 80 + 40 * 50 + highs, dht.stats().masked_max);
+}
+
+// A sensor that stops mid-frame: the read gives up on the first pulse that
+// never ends, one timeout after the last good bit, instead of timing out
+// every pulse still to come
+void test_timeout_aborts_read(void) {
+  DHT_nonblocking dht(dhtPin, DHT_TYPE_22);
+  sensor.set(0x02, 0x8C, 0x01, 0x5F);
+  sensor.bits = 10;
+  unsigned long pulses = 50;  // The low of the tenth bit
+  for (uint8_t i = 0; i < 9; i++)
+    pulses += 50 + ((sensor.frame[i / 8] & (0x80 >> (i % 8))) ? sensor.one_us : sensor.zero_us);
+  int16_t temperature, humidity;
+  TEST_ASSERT_FALSE(dhtReadOnce(dht, &temperature, &humidity));
+  TEST_ASSERT_EQUAL_UINT8(DHT_ERROR_DATA_HIGH, dht.stats().last_error);
+  TEST_ASSERT_EQUAL_UINT16(1, dht.stats().timeouts[DHT_ERROR_DATA_HIGH - 1]);
+  // The tenth high pulse is the one that never ends
+  TEST_ASSERT_UINT_WITHIN(20, 50 + 60 + 80 + pulses + DHT_TIMEOUT_US, dht.stats().masked_max);
+}
+
+// Bits are told apart by an absolute threshold of DHT_BIT_THRESHOLD_US,
+// whatever the sensor's actual pulse widths either side of it
+void test_bit_threshold(void) {
+  static const uint8_t zeros[] = {20, 28, 40, DHT_BIT_THRESHOLD_US - 2};
+  static const uint8_t ones[] = {DHT_BIT_THRESHOLD_US + 2, 70, 90, 120};
+  DHT_nonblocking dht(dhtPin, DHT_TYPE_22);
+  sensor.set(0x02, 0x8C, 0x80, 0x65);
+  for (uint8_t zero : zeros) {
+    for (uint8_t one : ones) {
+      sensor.zero_us = zero;
+      sensor.one_us = one;
+      int16_t temperature = 0, humidity = 0;
+      TEST_ASSERT_TRUE(dhtReadOnce(dht, &temperature, &humidity));
+      TEST_ASSERT_EQUAL_INT16(-101, temperature);
+      TEST_ASSERT_EQUAL_INT16(652, humidity);
+      TEST_ASSERT_UINT_WITHIN(2, zero, dht.stats().high_min);
+      TEST_ASSERT_UINT_WITHIN(2, one, dht.stats().high_max);
+      dht.reset_stats();
+    }
+  }
+}
+
+// A pulse that never ends times out after DHT_TIMEOUT_US exactly: the
+// hand-over and the 1 ms wait for the response high are all the read spends
+void test_timeout_is_one_ms(void) {
+  DHT_nonblocking dht(dhtPin, DHT_TYPE_22);
+  sensor.respond = false;
+  int16_t temperature, humidity;
+  TEST_ASSERT_FALSE(dhtReadOnce(dht, &temperature, &humidity));
+  TEST_ASSERT_EQUAL_UINT8(DHT_ERROR_RESPONSE_HIGH, dht.stats().last_error);
+  TEST_ASSERT_UINT_WITHIN(2, 50 + DHT_TIMEOUT_US, dht.stats().masked_max);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_dht11_decode);
+  RUN_TEST(test_dht21_decode);
+  RUN_TEST(test_dht22_decode);
+  RUN_TEST(test_checksum_error);
+  RUN_TEST(test_masked_window);
+  RUN_TEST(test_timeout_aborts_read);
+  RUN_TEST(test_bit_threshold);
+  RUN_TEST(test_timeout_is_one_ms);
+  return UNITY_END();
+}
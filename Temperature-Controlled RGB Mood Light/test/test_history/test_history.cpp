@@ -0,0 +1,157 @@
+// The reading history: readings must come back exactly, with times close to
+// the ones they were taken at, whether read after the fact or by a cursor
+// keeping up; and a quiet room must pack close to a reading per byte.
+#include <unity.h>
+#include <Arduino.h>
+#include <history.h>
+
+static const uint16_t periodMs = 2000;
+static const int total = 20000;
+
+struct Reading {
+  uint32_t at;
+  int16_t temp, humidity;
+};
+
+static Reading readings[total];
+static uint32_t seed;
+
+static uint32_t nextRandom() {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+// A random walk of 2 s readings: mostly small changes, an occasional jump,
+// reads delayed by one or two quick retries (258 ms each), and now and then a
+// few readings missed altogether
+static void makeTrace(bool quiet) {
+  uint32_t slot = 0;
+  int16_t temp = 225, humidity = 450;
+  for (int n = 0; n < total; n++) {
+    if (!quiet && nextRandom() % 50 == 0) slot += 1 + nextRandom() % 5;
+    uint32_t retries = quiet ? 0 : nextRandom() % 20 == 0 ? 1 + nextRandom() % 2 : 0;
+    readings[n].at = 5000 + slot * periodMs + retries * 258;
+    slot++;
+
+    if (quiet) {
+      temp += (int16_t)(nextRandom() % 3) - 1;
+      humidity += (int16_t)(nextRandom() % 5) - 2;
+    } else if (nextRandom() % 40 == 0) {
+      temp += (int16_t)(nextRandom() % 401) - 200;
+      humidity += (int16_t)(nextRandom() % 301) - 150;
+    } else {
+      temp += (int16_t)(nextRandom() % 9) - 4;
+      humidity += (int16_t)(nextRandom() % 15) - 7;
+    }
+    temp = min(max(temp, -400), 800);
+    humidity = min(max(humidity, 0), 1000);
+    readings[n].temp = temp;
+    readings[n].humidity = humidity;
+  }
+}
+
+// Read the cursor up to the newest reading, checking each against the trace
+// from *next on; returns the worst time error (ms)
+static uint32_t readBack(HistoryCursor &cursor, int *next) {
+  uint32_t worst = 0, at;
+  int16_t temp, humidity;
+  while (historyNext(cursor, &at, &temp, &humidity)) {
+    const Reading &reading = readings[(*next)++];
+    TEST_ASSERT_EQUAL_INT16(reading.temp, temp);
+    TEST_ASSERT_EQUAL_INT16(reading.humidity, humidity);
+    uint32_t error = at > reading.at ? at - reading.at : reading.at - at;
+    if (error > worst) worst = error;
+  }
+  return worst;
+}
+
+void setUp(void) { historyBegin(periodMs); }
+void tearDown(void) {}
+
+// Everything still held comes back, oldest first, exactly; times are off by
+// no more than the retry delays spread over a block
+void test_round_trip(void) {
+  seed = 45;
+  makeTrace(false);
+  for (int n = 0; n < total; n++) historyAdd(readings[n].at, readings[n].temp, readings[n].humidity);
+
+  HistoryCursor cursor;
+  historyRewind(cursor);
+  int next = total - historySamples();
+  uint32_t worst = readBack(cursor, &next);
+  TEST_ASSERT_EQUAL(total, next);
+
+  char message[64];
+  snprintf(message, sizeof(message), "%u readings held, times within %lu ms",
+           historySamples(), (unsigned long)worst);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_OR_EQUAL(2 * 258, worst);
+}
+
+// A cursor read after every reading added sees each one exactly once, even
+// as the oldest blocks are dropped under it
+void test_cursor_keeps_up(void) {
+  seed = 46;
+  makeTrace(false);
+  HistoryCursor cursor;
+  historyRewind(cursor);
+  int next = 0;
+  for (int n = 0; n < total; n++) {
+    historyAdd(readings[n].at, readings[n].temp, readings[n].humidity);
+    readBack(cursor, &next);
+    TEST_ASSERT_EQUAL(n + 1, next);
+  }
+}
+
+// The summary of the whole history agrees with the readings it covers
+void test_summary(void) {
+  seed = 47;
+  makeTrace(false);
+  for (int n = 0; n < total; n++) historyAdd(readings[n].at, readings[n].temp, readings[n].humidity);
+
+  HistorySummary summary;
+  uint32_t now = readings[total - 1].at;
+  TEST_ASSERT_TRUE(historySummary(now, now, &summary));
+  TEST_ASSERT_EQUAL_UINT16(historySamples(), summary.samples);
+  int first = total - summary.samples;
+  int16_t minTemp = 800, maxTemp = -400;
+  int32_t sumTemp = 0;
+  for (int n = first; n < total; n++) {
+    minTemp = min(minTemp, readings[n].temp);
+    maxTemp = max(maxTemp, readings[n].temp);
+    sumTemp += readings[n].temp;
+  }
+  TEST_ASSERT_EQUAL_UINT32(readings[first].at, summary.fromAt);
+  TEST_ASSERT_EQUAL_INT16(minTemp, summary.minTemp);
+  TEST_ASSERT_EQUAL_INT16(maxTemp, summary.maxTemp);
+  TEST_ASSERT_INT_WITHIN(1, sumTemp / summary.samples, summary.meanTemp);
+}
+
+// A quiet room changes by a few tenths between readings: one byte each, and
+// one reading per block for free in the header
+void test_quiet_density(void) {
+  seed = 48;
+  makeTrace(true);
+  for (int n = 0; n < total; n++) historyAdd(readings[n].at, readings[n].temp, readings[n].humidity);
+
+  // Block headers are 33 bytes on the AVR
+  uint32_t perKb = historySamples() * 1024UL / historyBytesUsed();
+  uint32_t perKbAll = historySamples() * 1024UL / (historyBlocks * (historyBlockBytes + 33UL));
+  uint32_t minutes = historySamples() * (uint32_t)periodMs / 60000;
+  char message[96];
+  snprintf(message, sizeof(message),
+           "%lu readings per KB of data, %lu per KB with headers, %lu minutes held",
+           (unsigned long)perKb, (unsigned long)perKbAll, (unsigned long)minutes);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_GREATER_OR_EQUAL(1024, perKb);
+  TEST_ASSERT_GREATER_OR_EQUAL(100, minutes);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_cursor_keeps_up);
+  RUN_TEST(test_summary);
+  RUN_TEST(test_quiet_density);
+  return UNITY_END();
+}
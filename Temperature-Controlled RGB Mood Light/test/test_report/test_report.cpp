@@ -0,0 +1,156 @@
+// Record formats and the TX ring: exact bytes of each format, records and
+// reportOut lines queued whole or dropped whole, and a pump that never
+// writes more than the UART has room for.
+#include <unity.h>
+#include <report.h>
+
+// A typical reading; records grow or shrink with the digits of the values
+static const ReportSample sample = {1234567, 239, 723, 750, 242, 756, 123};
+
+// Send everything queued and forget it
+static void drain() {
+  Serial.room = 1000;
+  while (reportRoom() < 255) reportPump();
+  Serial.sent.clear();
+  Serial.room = 63;
+}
+
+void setUp(void) {
+  reportSetFormat(REPORT_TEXT);
+  drain();
+}
+
+void tearDown(void) {}
+
+static std::string sent() {
+  Serial.room = 1000;
+  reportPump();
+  std::string out = Serial.sent;
+  Serial.sent.clear();
+  return out;
+}
+
+void test_text_record(void) {
+  TEST_ASSERT_TRUE(reportSample(sample));
+  std::string out = sent();
+  TEST_ASSERT_EQUAL_STRING(
+      "Humidity: 72.3% | Temperatures: 23.9C, 75.0F, Heat Index: 24.2C, 75.6F"
+      " | Max loop: 123 us\r\n",
+      out.c_str());
+  TEST_ASSERT_EQUAL(91, out.size());
+}
+
+void test_csv_record(void) {
+  reportSetFormat(REPORT_CSV);
+  TEST_ASSERT_EQUAL_STRING("ms,tempC,humidity,heatIndexC\r\n", sent().c_str());
+  TEST_ASSERT_TRUE(reportSample(sample));
+  std::string out = sent();
+  TEST_ASSERT_EQUAL_STRING("1234567,23.9,72.3,24.2\r\n", out.c_str());
+  TEST_ASSERT_EQUAL(24, out.size());
+}
+
+void test_negative_values(void) {
+  reportSetFormat(REPORT_CSV);
+  sent();
+  ReportSample cold = sample;
+  cold.tempC = -35;
+  cold.heatIndexC = -400;
+  cold.humidity = 5;
+  reportSample(cold);
+  TEST_ASSERT_EQUAL_STRING("1234567,-3.5,0.5,-40.0\r\n", sent().c_str());
+}
+
+void test_binary_record(void) {
+  reportSetFormat(REPORT_BINARY);
+  ReportSample cold = sample;
+  cold.tempC = -35;
+  TEST_ASSERT_TRUE(reportSample(cold));
+  TEST_ASSERT_TRUE(reportSample(cold));
+  std::string out = sent();
+  TEST_ASSERT_EQUAL(22, out.size());
+
+  const uint8_t *record = (const uint8_t *)out.data();
+  TEST_ASSERT_EQUAL_HEX8(0xA5, record[0]);
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)(record[1] + 1), record[12]);  // Sequence
+  TEST_ASSERT_EQUAL_UINT32(1234567, record[2] | record[3] << 8 |
+                                        (uint32_t)record[4] << 16 |
+                                        (uint32_t)record[5] << 24);
+  TEST_ASSERT_EQUAL_INT16(-35, (int16_t)(record[6] | record[7] << 8));
+  TEST_ASSERT_EQUAL_INT16(723, (int16_t)(record[8] | record[9] << 8));
+  uint8_t check = 0;
+  for (int i = 1; i < 10; i++) check ^= record[i];
+  TEST_ASSERT_EQUAL_HEX8(check, record[10]);
+}
+
+// Two 91-byte records fit in the 255 free bytes, a third doesn't: it is
+// dropped whole and counted, and what goes out is two whole records
+void test_full_ring_drops_whole_records(void) {
+  uint16_t dropped = reportDropped();
+  TEST_ASSERT_TRUE(reportSample(sample));
+  TEST_ASSERT_TRUE(reportSample(sample));
+  TEST_ASSERT_FALSE(reportSample(sample));
+  TEST_ASSERT_EQUAL_UINT16(dropped + 1, reportDropped());
+  TEST_ASSERT_EQUAL(255 - 2 * 91, reportRoom());
+  std::string out = sent();
+  TEST_ASSERT_EQUAL(2 * 91, out.size());
+  TEST_ASSERT_EQUAL(91, out.find("Humidity", 1));
+}
+
+// reportOut lines are held until their newline and then go whole or not at
+// all, like records; a record can't land in the middle of one
+void test_messages_are_whole_lines(void) {
+  uint16_t dropped = reportDropped();
+  reportOut.print(F("Warming "));
+  reportOut.print(12);
+  TEST_ASSERT_EQUAL(255, reportRoom());
+  reportSample(sample);
+  reportOut.println(F(" s"));
+  TEST_ASSERT_EQUAL(91 + 14, sent().size());
+
+  // Two records leave 73 bytes, a 27-byte line then 46: a 48-byte line
+  // no longer fits
+  reportSample(sample);
+  reportSample(sample);
+  reportOut.println(F("0123456789012345678901234"));
+  reportOut.println(F("0123456789012345678901234567890123456789012345"));
+  TEST_ASSERT_EQUAL_UINT16(dropped + 1, reportDropped());
+  std::string out = sent();
+  TEST_ASSERT_EQUAL(2 * 91 + 27, out.size());
+  TEST_ASSERT_EQUAL_STRING("0123456789012345678901234\r\n", out.c_str() + 2 * 91);
+
+  // A line too long for the line buffer is dropped, the next one isn't
+  for (int i = 0; i < 20; i++) reportOut.print(F("0123456789"));
+  reportOut.println();
+  reportOut.println(F("ok"));
+  TEST_ASSERT_EQUAL_UINT16(dropped + 2, reportDropped());
+  TEST_ASSERT_EQUAL_STRING("ok\r\n", sent().c_str());
+}
+
+// The pump writes no more than availableForWrite() and picks up from there
+void test_pump_respects_uart_room(void) {
+  reportSample(sample);
+  Serial.room = 10;
+  reportPump();
+  TEST_ASSERT_EQUAL(10, Serial.sent.size());
+  TEST_ASSERT_EQUAL(0, Serial.room);
+  reportPump();
+  TEST_ASSERT_EQUAL(10, Serial.sent.size());
+  Serial.room = 63;
+  reportPump();
+  TEST_ASSERT_EQUAL(73, Serial.sent.size());
+  Serial.room = 63;
+  reportPump();
+  TEST_ASSERT_EQUAL(91, Serial.sent.size());
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_text_record);
+  RUN_TEST(test_csv_record);
+  RUN_TEST(test_negative_values);
+  RUN_TEST(test_binary_record);
+  RUN_TEST(test_full_ring_drops_whole_records);
+  RUN_TEST(test_messages_are_whole_lines);
+  RUN_TEST(test_pump_respects_uart_room);
+  return UNITY_END();
+}
@@ -0,0 +1,139 @@
+// The task scheduler on a virtual clock: tasks run in due and priority
+// order through any mix of starts and stops, and a realistic task mix keeps
+// its timing across a micros() wrap, with the occupancy it should have.
+#include <unity.h>
+#include <scheduler.h>
+
+static uint32_t now;
+static unsigned long clock() { return now; }
+
+static uint32_t seed;
+
+static uint32_t nextRandom() {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+// Order: one-shot tasks that log their runs and take no time
+
+static const uint8_t orderTasks = 8;
+static uint8_t ranIds[orderTasks * 2];
+static uint8_t ranCount;
+
+template <uint8_t id> static void logRun() { ranIds[ranCount++] = id; }
+
+void test_due_and_priority_order(void) {
+  Task tasks[orderTasks] = {
+    {logRun<0>, 0, 3}, {logRun<1>, 0, 1}, {logRun<2>, 0, 0}, {logRun<3>, 0, 2},
+    {logRun<4>, 0, 3}, {logRun<5>, 0, 5}, {logRun<6>, 0, 4}, {logRun<7>, 0, 6},
+  };
+  Scheduler scheduler(tasks, orderTasks, clock);
+  now = 0xFFFF0000u; // Through the wrap and back round
+  seed = 46;
+
+  // Expected due time of each pending task
+  bool pending[orderTasks] = {};
+  uint32_t due[orderTasks];
+  for (int round = 0; round < 20000; round++) {
+    uint8_t id = nextRandom() % orderTasks;
+    if (nextRandom() % 4 == 0) {
+      scheduler.stop(id);
+      pending[id] = false;
+    } else {
+      uint32_t delay = nextRandom() % 2000;
+      scheduler.start(id, delay);
+      pending[id] = true;
+      due[id] = now + delay;
+    }
+    if (nextRandom() % 3 != 0) continue;
+
+    now += nextRandom() % 1500;
+    ranCount = 0;
+    scheduler.run();
+    // Every task that was due ran, once, in order
+    for (uint8_t i = 0; i < ranCount; i++) {
+      uint8_t ran = ranIds[i];
+      TEST_ASSERT_TRUE(pending[ran]);
+      TEST_ASSERT_TRUE((int32_t)(now - due[ran]) >= 0);
+      pending[ran] = false;
+      if (i > 0) {
+        uint8_t before = ranIds[i - 1];
+        int32_t order = due[before] - due[ran];
+        TEST_ASSERT_TRUE(order < 0 || (order == 0 && tasks[before].priority <= tasks[ran].priority));
+      }
+    }
+    for (uint8_t other = 0; other < orderTasks; other++) {
+      if (pending[other]) TEST_ASSERT_TRUE((int32_t)(now - due[other]) < 0);
+      TEST_ASSERT_EQUAL(pending[other], scheduler.pending(other));
+    }
+  }
+}
+
+// Timing: a sketch-like mix, each task costing its run time on the clock
+
+static const uint32_t loopUs = 10;  // A pass through loop() besides run()
+
+template <uint32_t costUs> static void work() { now += costUs; }
+
+enum { FAST, FADE, PUMP, SERIAL, SLOW, TASKS };
+
+void test_mix_timing(void) {
+  Task tasks[TASKS] = {
+    {work<50>, 1000, 0},       // Sensor poll
+    {work<300>, 20000, 1},     // Fade
+    {work<200>, 5000, 2},      // Report pump
+    {work<100>, 10000, 3},     // Serial
+    {work<8000>, 2000000, 4},  // Something slow now and then
+  };
+  Scheduler scheduler(tasks, TASKS, clock);
+  now = 0xFFFFFFFFu - 5000000; // micros() wraps 5 s in
+  scheduler.begin();
+
+  const uint32_t seconds = 60;
+  uint32_t start = now;
+  uint16_t occupancy = 0, lowest = 1000, highest = 0;
+  while (now - start < seconds * 1000000) {
+    scheduler.run();
+    now += loopUs;
+    if (scheduler.occupancy() != occupancy && now - start > 2000000) {
+      occupancy = scheduler.occupancy();
+      if (occupancy < lowest) lowest = occupancy;
+      if (occupancy > highest) highest = occupancy;
+    }
+  }
+
+  // Sum of cost / period: 5 + 1.5 + 4 + 1 %, and in every other 1 s window
+  // the slow task's 0.8 %, less the 1 ms runs it made skip
+  const uint16_t quiet = 115, busy = 115 + 8;
+  char message[120];
+  snprintf(message, sizeof(message),
+           "occupancy %u.%u-%u.%u %%, 20 ms task at most %lu us late, 1 ms task missed %u",
+           lowest / 10, lowest % 10, highest / 10, highest % 10,
+           (unsigned long)tasks[FADE].maxLateUs, tasks[FAST].misses);
+  TEST_MESSAGE(message);
+
+  // Every run happened, each task's phase kept
+  TEST_ASSERT_UINT_WITHIN(1, seconds * 50, tasks[FADE].runs);
+  TEST_ASSERT_UINT_WITHIN(1, seconds * 200, tasks[PUMP].runs);
+  TEST_ASSERT_UINT_WITHIN(1, seconds / 2, tasks[SLOW].runs);
+  // Only the slow task's 8 ms can hold the 1 ms task past its deadline:
+  // once each time, and the runs it held up are skipped, not queued
+  TEST_ASSERT_EQUAL_UINT16(tasks[SLOW].runs, tasks[FAST].misses);
+  TEST_ASSERT_UINT_WITHIN(tasks[SLOW].runs * 8, seconds * 1000, tasks[FAST].runs);
+  // The 20 ms task shares its start with the slower ones and goes first:
+  // behind the 1 ms task and a loop pass at most
+  TEST_ASSERT_LESS_OR_EQUAL(50 + loopUs, tasks[FADE].maxLateUs);
+  TEST_ASSERT_EQUAL_UINT16(0, tasks[FADE].misses);
+  TEST_ASSERT_UINT_WITHIN(1, quiet, lowest);
+  TEST_ASSERT_UINT_WITHIN(1, busy, highest);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_due_and_priority_order);
+  RUN_TEST(test_mix_timing);
+  return UNITY_END();
+}
@@ -0,0 +1,109 @@
+// The temperature filter and bands on synthetic traces: readings hovering
+// at both thresholds with noise and spikes must not make the band flap, and
+// a real change must still come through promptly.
+#include <unity.h>
+#include <temp_filter.h>
+
+// The sketch's bands: cold below 20 C, hot from 30 C, 0.5 C of hysteresis
+static const BandConfig bands = {200, 300, 5};
+
+static uint32_t seed;
+
+static uint32_t nextRandom() {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+// Band by plain thresholds, as the sketch did before the filter
+static TempBand rawBand(int16_t temp) {
+  if (temp < bands.comfortFrom) return BAND_COLD;
+  if (temp < bands.hotFrom) return BAND_COMFORT;
+  return BAND_HOT;
+}
+
+// 3000 readings: sitting on the 20 C threshold, a climb to the 30 C one,
+// sitting there, then a climb to 32 C. Noise of +/-0.3 C, and a 4 C spike
+// one reading in 100.
+static int16_t traceReading(int n) {
+  int16_t level;
+  if (n < 1200) level = 200;
+  else if (n < 1500) level = 200 + (n - 1200) / 3;
+  else if (n < 2400) level = 300;
+  else if (n < 2600) level = 300 + (n - 2400) / 10;
+  else level = 320;
+  int16_t reading = level + (int16_t)(nextRandom() % 7) - 3;
+  if (nextRandom() % 100 == 0) reading += nextRandom() % 2 ? 40 : -40;
+  return reading;
+}
+
+void test_hovering_trace(void) {
+  TempFilter filter;
+  filterReset(filter);
+  TempBand filtered = BAND_UNKNOWN, raw = BAND_UNKNOWN;
+  int filteredChanges = 0, rawChanges = 0, hotAt = -1;
+  seed = 40;
+  for (int n = 0; n < 3000; n++) {
+    int16_t reading = traceReading(n);
+    if (bandUpdate(&filtered, bands, filterAdd(filter, reading)) && n > 0) {
+      filteredChanges++;
+      if (filtered == BAND_HOT) hotAt = n;
+    }
+    if (rawBand(reading) != raw && n > 0) rawChanges++;
+    raw = rawBand(reading);
+  }
+
+  char message[80];
+  snprintf(message, sizeof(message),
+           "band changes: raw %d, filtered %d (hot at reading %d)", rawChanges,
+           filteredChanges, hotAt);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_GREATER_THAN(500, rawChanges);
+  // Out of cold on the first climb if it started there, into hot on the
+  // second, and nothing while sitting on a threshold
+  TEST_ASSERT_GREATER_OR_EQUAL(1, filteredChanges);
+  TEST_ASSERT_LESS_OR_EQUAL(2, filteredChanges);
+  TEST_ASSERT_EQUAL(BAND_HOT, filtered);
+  // The second climb passes 30.5 C at reading 2450
+  TEST_ASSERT_GREATER_OR_EQUAL(2450, hotAt);
+  TEST_ASSERT_LESS_OR_EQUAL(2470, hotAt);
+}
+
+// A step of 5 C is followed to within 0.1 C in 15 readings: two for the
+// median, then the 1/4 average
+void test_step_response(void) {
+  TempFilter filter;
+  filterReset(filter);
+  for (int n = 0; n < 20; n++) filterAdd(filter, 250);
+  int settled = -1;
+  for (int n = 1; n <= 40; n++) {
+    int16_t smooth = filterAdd(filter, 300);
+    if (n <= 2) TEST_ASSERT_EQUAL_INT16(250, smooth);
+    if (settled < 0 && smooth >= 299) settled = n;
+  }
+  char message[48];
+  snprintf(message, sizeof(message), "5 C step settled in %d readings", settled);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_GREATER_THAN(0, settled);
+  TEST_ASSERT_LESS_OR_EQUAL(15, settled);
+}
+
+// A lone spike, however large, never gets past the median
+void test_spike_rejected(void) {
+  TempFilter filter;
+  filterReset(filter);
+  for (int n = 0; n < 10; n++) filterAdd(filter, 250);
+  TEST_ASSERT_EQUAL_INT16(250, filterAdd(filter, 900));
+  TEST_ASSERT_EQUAL_INT16(250, filterAdd(filter, 250));
+  TEST_ASSERT_EQUAL_INT16(250, filterAdd(filter, -400));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_hovering_trace);
+  RUN_TEST(test_step_response);
+  RUN_TEST(test_spike_rejected);
+  return UNITY_END();
+}
@@ -0,0 +1,226 @@
+// The temperature trend: its slope and projection against a closed-form
+// least-squares fit, through many turns of the ring; and heating curves
+// replayed through the sketch's filter, bands and pre-alert rule, which must
+// warn at least the horizon ahead of the hot alert on a steady rise and
+// never on a room sitting just under it.
+//
+// The curves are synthetic, read every 2 s with +/-0.15 C of noise and
+// rounded to the sensor's 0.1 C.
+#include <unity.h>
+#include <math.h>
+#include <temp_filter.h>
+#include <temp_trend.h>
+
+static const uint16_t periodMs = 2000;
+
+// The sketch's bands and pre-alert settings
+static const BandConfig bands = {200, 300, 5};
+static const uint32_t horizonMs = 120000;
+static const int16_t minRate = 3;
+
+static uint32_t seed;
+
+static uint32_t nextRandom() {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+// -0.15 to +0.15 C, in tenths
+static double noise() { return (nextRandom() % 3001) / 1000.0 - 1.5; }
+
+// Least-squares fit over the last trendWindow readings, oldest first
+static void fit(const int16_t *readings, double *slope, double *newest) {
+  double n = trendWindow, sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
+  for (uint8_t x = 0; x < trendWindow; x++) {
+    sumX += x;
+    sumY += readings[x];
+    sumXY += x * (double)readings[x];
+    sumXX += (double)x * x;
+  }
+  *slope = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+  *newest = (sumY - *slope * sumX) / n + *slope * (n - 1);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_not_ready_until_full(void) {
+  TempTrend trend;
+  trendReset(trend);
+  for (uint8_t n = 0; n < trendWindow - 1; n++) {
+    trendAdd(trend, 250 + n * 10);
+    TEST_ASSERT_FALSE(trendReady(trend));
+    TEST_ASSERT_EQUAL_INT16(0, trendPerMinute(trend, periodMs));
+    TEST_ASSERT_EQUAL_UINT32(trendNever, trendTimeTo(trend, 300, periodMs));
+  }
+  trendAdd(trend, 250);
+  TEST_ASSERT_TRUE(trendReady(trend));
+}
+
+// A random walk with jumps, 5000 readings: 156 turns of the ring, each
+// reading checked against the fit done from scratch
+void test_slope_matches_fit(void) {
+  TempTrend trend;
+  trendReset(trend);
+  int16_t readings[5000];
+  seed = 44;
+  int16_t temp = 250;
+  double worstRate = 0, worstTime = 0;
+  for (int n = 0; n < 5000; n++) {
+    temp += (int16_t)(nextRandom() % 7) - 3 + (nextRandom() % 200 == 0 ? 100 : 0);
+    if (nextRandom() % 300 == 0) temp = 100 + nextRandom() % 300;
+    readings[n] = temp;
+    trendAdd(trend, temp);
+    if (n < trendWindow - 1) continue;
+
+    double slope, newest;
+    fit(readings + n - (trendWindow - 1), &slope, &newest);
+    double perMinute = slope * 60000 / periodMs;
+    double rateError = fabs(trendPerMinute(trend, periodMs) - perMinute);
+    if (rateError > worstRate) worstRate = rateError;
+    if (rateError >= 1.0) printf("n=%d got %d want %f temp %d\n", n, trendPerMinute(trend, periodMs), perMinute, temp);
+    TEST_ASSERT_TRUE(rateError <= 0.5 + 1e-6);  // Rounded to the tenth
+
+    int16_t threshold = 305;
+    uint32_t timeTo = trendTimeTo(trend, threshold, periodMs);
+    if (newest >= threshold + 0.001) {
+      TEST_ASSERT_EQUAL_UINT32(0, timeTo);
+    } else if (slope < -0.001) {
+      TEST_ASSERT_EQUAL_UINT32(trendNever, timeTo);
+    } else if (slope > 0.001 && newest < threshold - 0.001) {
+      double expected = (threshold - newest) / slope * periodMs;
+      if (expected < 3600000.0) {
+        // The projection is counted in tenths of a reading
+        double error = fabs(timeTo - expected);
+        if (error > worstTime) worstTime = error;
+        TEST_ASSERT_TRUE(error <= periodMs / 10 + 1);
+      }
+    }
+  }
+  char message[80];
+  snprintf(message, sizeof(message), "worst errors: rate %.2f tenths/min, time to 30.5 C %.0f ms",
+           worstRate, worstTime);
+  TEST_MESSAGE(message);
+}
+
+// The pre-alert rule of updatePreAlert() in main.cpp
+static void preAlert(const TempTrend &trend, TempBand band, bool *warning) {
+  if (band == BAND_HOT) {
+    *warning = false;
+    return;
+  }
+  uint32_t timeToHot = trendTimeTo(trend, bands.hotFrom + bands.hysteresis, periodMs);
+  int16_t rate = trendPerMinute(trend, periodMs);
+  if (!*warning && timeToHot <= horizonMs && rate >= minRate) {
+    *warning = true;
+  } else if (*warning && timeToHot > 2 * horizonMs) {
+    *warning = false;
+  }
+}
+
+struct Replay {
+  long warnedAt;  // ms of the first pre-alert, -1 for none
+  long hotAt;     // ms the band went hot, -1 for never
+  int warnings;
+};
+
+// Runs a curve (tenths at a time in ms) for the given time as pollSensor()
+// does: filter, trend, band, then the pre-alert
+template <typename Curve>
+static Replay replay(Curve curve, long durationMs) {
+  TempFilter filter;
+  TempTrend trend;
+  filterReset(filter);
+  trendReset(trend);
+  TempBand band = BAND_UNKNOWN;
+  bool warning = false;
+  Replay result = {-1, -1, 0};
+  for (long at = 0; at < durationMs; at += periodMs) {
+    int16_t temp = (int16_t)lround(curve(at) + noise());
+    int16_t smooth = filterAdd(filter, temp);
+    trendAdd(trend, temp);
+    // The first reading is banded by the plain thresholds, so a room that
+    // boots at 30.0 C starts hot; only a change after that is a hot alert
+    if (bandUpdate(&band, bands, smooth) && band == BAND_HOT && at > 0 && result.hotAt < 0) {
+      result.hotAt = at;
+    }
+    bool was = warning;
+    preAlert(trend, band, &warning);
+    if (warning && !was) {
+      result.warnings++;
+      if (result.warnedAt < 0) result.warnedAt = at;
+    }
+  }
+  return result;
+}
+
+// Lead of the pre-alert over the hot alert across 50 runs: on average at
+// least the horizon, and never much less in a noisy run
+static void leads(const char *name, double (*curve)(long), long durationMs) {
+  long sum = 0, least = 0x7FFFFFFF;
+  for (int run = 0; run < 50; run++) {
+    Replay result = replay(curve, durationMs);
+    TEST_ASSERT_TRUE(result.hotAt >= 0);
+    TEST_ASSERT_TRUE(result.warnedAt >= 0);
+    long lead = result.hotAt - result.warnedAt;
+    sum += lead;
+    if (lead < least) least = lead;
+  }
+  char message[96];
+  snprintf(message, sizeof(message), "%s: lead mean %ld s, least %ld s", name, sum / 50000,
+           least / 1000);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_GREATER_OR_EQUAL(horizonMs, sum / 50);
+  TEST_ASSERT_GREATER_OR_EQUAL(horizonMs * 3 / 4, least);
+}
+
+// 10 minutes at 22 C, then a steady rise: 8.5 C to go, so even the fast
+// ramp's fit has settled on the slope by the time it matters
+static double ramp(long at, double perMinute) {
+  return at < 600000 ? 220 : 220 + (at - 600000) * perMinute / 6000.0;
+}
+static double slowRamp(long at) { return ramp(at, 0.5); }
+static double ramp(long at) { return ramp(at, 1.0); }
+static double fastRamp(long at) { return ramp(at, 2.0); }
+
+// An enclosure warming from 24 C toward 36 C, tau 10 minutes
+static double exponential(long at) { return 360 - 120 * exp(-at / 600000.0); }
+
+void test_ramps_warn_ahead(void) {
+  seed = 440;
+  leads("0.5 C/min", slowRamp, 50 * 60000L);
+  leads("1 C/min", ramp, 25 * 60000L);
+  leads("2 C/min", fastRamp, 20 * 60000L);
+}
+
+void test_exponential_warns_ahead(void) {
+  seed = 441;
+  leads("24 -> 36 C, tau 10 min", exponential, 60 * 60000L);
+}
+
+// Two hours just under the hot alert: no pre-alert, and no hot alert
+static double flatHigh(long) { return 299; }
+static double flatLow(long) { return 295; }
+
+void test_flat_never_warns(void) {
+  seed = 442;
+  int warnings = 0, hot = 0;
+  for (int run = 0; run < 50; run++) {
+    Replay low = replay(flatLow, 120 * 60000L);
+    Replay high = replay(flatHigh, 120 * 60000L);
+    warnings += low.warnings + high.warnings;
+    hot += (low.hotAt >= 0) + (high.hotAt >= 0);
+  }
+  TEST_ASSERT_EQUAL(0, hot);
+  TEST_ASSERT_EQUAL(0, warnings);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_not_ready_until_full);
+  RUN_TEST(test_slope_matches_fit);
+  RUN_TEST(test_ramps_warn_ahead);
+  RUN_TEST(test_exponential_warns_ahead);
+  RUN_TEST(test_flat_never_warns);
+  return UNITY_END();
+}
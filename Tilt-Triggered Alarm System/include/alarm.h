@@ -0,0 +1,63 @@
+// Alarm states for the tilt alarm.
+//
+//   DISARMED   Tilts are reported but don't alarm.
+//   COOLDOWN   Armed, but tilts are ignored for cooldownMs (to put the
+//              device down after arming, or after resetting an alarm).
+//              Still tilted at the end of it goes straight to PRE_ALARM.
+//   ARMED      Waiting for a tilt; the board may sleep.
+//   PRE_ALARM  A tilt was confirmed: entryDelayMs to disarm before the
+//              alarm goes off.
+//   TRIGGERED  Alarm sounding, for at least minAlarmMs and for as long as
+//              the device stays tilted.
+//   LATCHED    The device is level again, but the alarm stays latched (with
+//              a reminder beep) until it is reset or disarmed. A new tilt
+//              triggers it again.
+//
+// The buzzer cadence for each state comes from a table and gets more urgent
+// the longer the alarm sounds. Everything is worked out from the time passed
+// in, so nothing here blocks or reads a clock itself.
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <stdint.h>
+
+enum AlarmState : uint8_t {
+  ALARM_DISARMED,
+  ALARM_COOLDOWN,
+  ALARM_ARMED,
+  ALARM_PRE_ALARM,
+  ALARM_TRIGGERED,
+  ALARM_LATCHED
+};
+
+struct AlarmConfig {
+  uint32_t entryDelayMs;
+  uint32_t minAlarmMs;
+  uint32_t cooldownMs;
+};
+
+struct Alarm {
+  AlarmState state;
+  uint32_t enteredAt; // When the current state began (ms)
+  bool tilted;        // Last debounced tilt state
+};
+
+void alarmBegin(Alarm &alarm, uint32_t now);
+
+// Commands. Each returns false if it doesn't apply in the current state.
+bool alarmArm(Alarm &alarm, uint32_t now);    // Disarmed -> cooldown
+bool alarmDisarm(Alarm &alarm, uint32_t now); // Any armed state -> disarmed
+bool alarmReset(Alarm &alarm, uint32_t now);  // Latched -> cooldown
+
+// A confirmed tilt change
+void alarmTilt(Alarm &alarm, bool tilted, uint32_t now);
+
+// Move on any timed transitions. Returns true when the state changed.
+bool alarmUpdate(Alarm &alarm, const AlarmConfig &config, uint32_t now);
+
+// Whether the buzzer should be on at this moment
+bool alarmBuzzer(const Alarm &alarm, uint32_t now);
+
+const char *alarmStateName(AlarmState state);
+
+#endif
@@ -0,0 +1,40 @@
+// Integrating debouncer with a transition count, for the tilt switch.
+//
+// Fed one raw sample at a time (1 kHz from the tilt sampling interrupt). An
+// integrator collects evidence for a change: each sample that disagrees with
+// the debounced state adds one, each that agrees takes two away (down to 0),
+// and the state changes when it reaches stableSamples. A clean change is
+// confirmed after exactly stableSamples; a single glitch never is; and
+// chatter only gets through once the switch spends more than two thirds of
+// its time the other way, so a ball rattling about doesn't random-walk its
+// way to a false tilt. Each sample costs the same whatever the input.
+//
+// Alongside, raw changes are counted over fixed windows of windowSamples.
+// The count for the last full window measures vibration: a ball rolling
+// around while the device is jostled makes many, a sustained tilt almost
+// none.
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+
+struct Debouncer {
+  uint8_t stableSamples;
+  uint8_t count;        // Integrator, 0 .. stableSamples
+  bool state;           // Debounced: true = open (tilted)
+  bool lastRaw;
+  uint16_t settling;    // Samples since the integrator left its end
+  uint16_t settled;     // settling at the last change of state
+  uint16_t windowSamples;
+  uint16_t windowLeft;
+  uint16_t transitions; // Raw changes so far in this window
+  uint16_t vibration;   // Raw changes in the last full window
+};
+
+void debounceBegin(Debouncer &debouncer, uint8_t stableSamples,
+                   uint16_t windowSamples, bool open);
+
+// Add a sample; returns true when the debounced state changes
+bool debounceSample(Debouncer &debouncer, bool open);
+
+#endif
@@ -0,0 +1,41 @@
+// Power saving for battery use.
+//
+// powerBegin() switches off, through the PRR registers, every peripheral the
+// alarm never uses: ADC, analog comparator, SPI, TWI, Timers 1 and 3-5 and
+// USARTs 1-3. The serial port is only powered and started when there is
+// something to print (serialWake()), and shut down again before sleeping.
+//
+// powerDown() puts the ATmega2560 in SLEEP_MODE_PWR_DOWN until an external
+// interrupt, or until a falling edge on RXD0 (PCINT8), so that serial input
+// wakes the board too. The USART is off while asleep, so the characters that
+// wake it are lost; powerWokeBySerial() tells the sketch to start Serial and
+// stay up for the command that follows. millis() and micros() stand still
+// while asleep, so millis() counts time spent awake.
+#ifndef POWER_SAVE_H
+#define POWER_SAVE_H
+
+#include <stdint.h>
+
+struct PowerStats {
+  uint32_t sleeps;
+  uint32_t lastAwakeMs; // Awake time before the last sleep
+  uint32_t maxAwakeMs;
+};
+
+void powerBegin(unsigned long baud);
+
+// Power up the USART and start Serial, if it isn't already
+void serialWake();
+// True once everything queued has been sent (or Serial is off)
+bool serialIdle();
+void serialSleep();
+
+// Call with interrupts off, after arming the wake-up interrupt; they are on
+// again when it returns
+void powerDown();
+// Whether the last powerDown() ended on serial input
+bool powerWokeBySerial();
+
+const PowerStats &powerStats();
+
+#endif
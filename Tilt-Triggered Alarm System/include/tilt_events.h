@@ -0,0 +1,78 @@
+// Tilt detection for the alarm.
+//
+// Timer2 interrupts at 1 kHz and samples the tilt switch into a debouncer
+// (see debounce.h). When the debounced state changes, the interrupt handler
+// switches the buzzer to match straight away (a direct port write) and
+// records the change in an event queue, which loop() empties whenever it
+// gets to it. The debouncer's transition count tells a jostled device from
+// a tilted one.
+//
+// The queue has one writer (the interrupt) and one reader (loop()), each
+// owning one index, so neither side needs to turn interrupts off. When it is
+// full, new events are counted as dropped; the buzzer still follows them.
+//
+// Timer2 is taken over, so analogWrite() on pins 9 and 10 and tone() are not
+// available.
+//
+// For sleep, tiltArmWake() stops the sampling and hands the pin to its
+// external interrupt, which can wake the board from power-down. A tilt edge
+// then sounds the buzzer at once, before anything is debounced, and restarts
+// the sampling; if the debouncer doesn't go on to confirm the tilt (the
+// integrator drains back to zero), the buzzer is switched off again and the
+// wake is counted as false.
+//
+// tiltFollowBuzzer(false) leaves the buzzer to the sketch instead: the
+// interrupts then only debounce, queue and count.
+#ifndef TILT_EVENTS_H
+#define TILT_EVENTS_H
+
+#include <stdint.h>
+
+const uint8_t tiltQueueSize = 16; // Power of two
+const uint16_t tiltWindowMs = 250; // Vibration window
+
+struct TiltEvent {
+  uint32_t atMs;     // Sample clock (ms) when the change was confirmed
+  uint16_t settleMs; // From the first sample that disagreed to confirmation
+  bool tilted;       // Switch open (ball off the contacts)
+};
+
+enum TiltActivity : uint8_t {
+  TILT_STILL,   // Level and quiet
+  TILT_JOSTLED, // Switch chattering: the device is being moved about
+  TILT_HELD     // Tilted and quiet
+};
+
+struct TiltWakeStats {
+  uint16_t wakes;
+  uint16_t falseWakes;
+  uint16_t lastConfirmMs; // Wake edge to confirmed tilt
+  uint16_t maxConfirmMs;
+};
+
+// The switch has to read the same for stableMs (1-255) before a change
+// counts. tiltPin must be one of 18-21 (INT3-INT0) for tiltArmWake().
+// Sets up the pull-up, the buzzer output and Timer2.
+void tiltBegin(uint8_t tiltPin, uint8_t buzzerPin, uint8_t stableMs);
+void tiltSetStableMs(uint8_t stableMs);
+// Whether the interrupts switch the buzzer (the default)
+void tiltFollowBuzzer(bool follow);
+
+bool tiltNextEvent(TiltEvent *event);
+bool tiltEventWaiting();
+bool tiltIsTilted();          // Debounced
+uint16_t tiltVibration();     // Raw switch changes in the last window
+TiltActivity tiltActivity();
+uint16_t tiltDropped();
+
+// Nothing going on: debounced level, switch closed and quiet, queue empty
+bool tiltSleepReady();
+// With interrupts off, just before sleeping: stop sampling and wake on the
+// next tilt edge. Returns false (and keeps sampling) if the switch is open.
+bool tiltArmWake();
+TiltWakeStats tiltWakeStats();      // A consistent copy
+
+// Raw changes per window from which the device counts as jostled
+extern uint8_t tiltJostleThreshold;
+
+#endif
@@ -0,0 +1,85 @@
+// Cooperative task scheduler for the sensor sketches.
+//
+// The sketch declares its tasks in a static table and calls run() from
+// loop(). Pending tasks sit in a min-heap ordered by due time (ties go to the
+// lower priority number), so run() only looks at the earliest one. A task is
+// either periodic, keeping its phase from one run to the next, or one-shot,
+// run once each time it is started.
+//
+// For each task the scheduler counts runs and deadline misses and keeps the
+// worst start lateness and run time. Over every window it also measures how
+// much of the time was spent inside tasks (occupancy).
+//
+// Time comes from the clock passed in (micros() on the board), so the
+// scheduler has no Arduino dependency and builds on a PC. Times are 32-bit
+// microseconds and wrap safely as long as periods stay under 35 minutes.
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+const uint8_t schedulerMaxTasks = 16;
+
+typedef void (*TaskFunction)();
+typedef unsigned long (*SchedulerClock)(); // Microseconds, like micros()
+
+struct Task {
+  TaskFunction run;
+  uint32_t periodUs;   // 0 = one-shot
+  uint8_t priority;    // Lower runs first when due together
+  uint32_t deadlineUs; // Allowed start lateness, 0 = one period (one-shot: none)
+
+  // Kept by the scheduler
+  uint32_t due;
+  uint32_t runs;
+  uint16_t misses;
+  uint32_t maxLateUs;
+  uint32_t maxRunUs;
+  uint8_t slot;        // Position in the heap, or noSlot
+};
+
+class Scheduler {
+public:
+  static const uint8_t noSlot = 0xFF;
+
+  Scheduler(Task *tasks, uint8_t count, SchedulerClock clock);
+
+  // Start every periodic task, first run one period from now
+  void begin();
+  // (Re)start a task, first run after delayUs
+  void start(uint8_t id, uint32_t delayUs = 0);
+  void stop(uint8_t id);
+  bool pending(uint8_t id) const;
+
+  // Run the tasks that are due. Returns the time until the next one is due
+  // (0 if one already is, 0xFFFFFFFF if nothing is pending).
+  uint32_t run();
+
+  const Task &task(uint8_t id) const;
+  // Share of the last full window spent running tasks, in 0.1 %
+  uint16_t occupancy() const;
+  uint32_t longestRunUs() const;
+  void resetStats();
+
+  uint32_t windowUs = 1000000;
+
+private:
+  bool earlier(uint8_t a, uint8_t b) const;
+  void place(uint8_t slot, uint8_t id);
+  void siftUp(uint8_t slot);
+  void siftDown(uint8_t slot);
+  void push(uint8_t id);
+  void remove(uint8_t id);
+
+  Task *tasks;
+  uint8_t count;
+  SchedulerClock clock;
+  uint8_t heap[schedulerMaxTasks];
+  uint8_t heapSize;
+
+  uint32_t windowStart;
+  uint32_t busyUs;
+  uint16_t lastOccupancy;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include <Arduino.h>
+#include "alarm.h"
+
+// Buzzer cadence: from afterMs into the state, onMs on then offMs off, over
+// and over (offMs 0 = on the whole time). A state with no entry is silent.
+struct Cadence {
+  AlarmState state;
+  uint32_t afterMs;
+  uint16_t onMs;
+  uint16_t offMs;
+};
+
+const Cadence cadences[] PROGMEM = {
+  {ALARM_PRE_ALARM, 0, 100, 900},     // Chirp once a second
+  {ALARM_PRE_ALARM, 5000, 100, 400},  // Twice a second near the end
+  {ALARM_TRIGGERED, 0, 500, 500},
+  {ALARM_TRIGGERED, 15000, 200, 200},
+  {ALARM_TRIGGERED, 45000, 1, 0},     // Continuous
+  {ALARM_LATCHED, 0, 100, 4900},      // Reminder every 5 s
+};
+
+const uint8_t cadenceCount = sizeof(cadences) / sizeof(cadences[0]);
+
+static void enter(Alarm &alarm, AlarmState state, uint32_t now) {
+  alarm.state = state;
+  alarm.enteredAt = now;
+}
+
+void alarmBegin(Alarm &alarm, uint32_t now) {
+  alarm.tilted = false;
+  enter(alarm, ALARM_DISARMED, now);
+}
+
+bool alarmArm(Alarm &alarm, uint32_t now) {
+  if (alarm.state != ALARM_DISARMED) return false;
+  enter(alarm, ALARM_COOLDOWN, now);
+  return true;
+}
+
+bool alarmDisarm(Alarm &alarm, uint32_t now) {
+  if (alarm.state == ALARM_DISARMED) return false;
+  enter(alarm, ALARM_DISARMED, now);
+  return true;
+}
+
+bool alarmReset(Alarm &alarm, uint32_t now) {
+  if (alarm.state != ALARM_LATCHED) return false;
+  enter(alarm, ALARM_COOLDOWN, now);
+  return true;
+}
+
+void alarmTilt(Alarm &alarm, bool tilted, uint32_t now) {
+  alarm.tilted = tilted;
+  if (!tilted) return;
+  if (alarm.state == ALARM_ARMED) {
+    enter(alarm, ALARM_PRE_ALARM, now);
+  } else if (alarm.state == ALARM_LATCHED) {
+    enter(alarm, ALARM_TRIGGERED, now);
+  }
+}
+
+bool alarmUpdate(Alarm &alarm, const AlarmConfig &config, uint32_t now) {
+  uint32_t inState = now - alarm.enteredAt;
+  switch (alarm.state) {
+    case ALARM_COOLDOWN:
+      if (inState < config.cooldownMs) return false;
+      // Still tilted at the end counts as a tilt
+      enter(alarm, alarm.tilted ? ALARM_PRE_ALARM : ALARM_ARMED, now);
+      return true;
+    case ALARM_PRE_ALARM:
+      if (inState < config.entryDelayMs) return false;
+      enter(alarm, ALARM_TRIGGERED, now);
+      return true;
+    case ALARM_TRIGGERED:
+      if (inState < config.minAlarmMs || alarm.tilted) return false;
+      enter(alarm, ALARM_LATCHED, now);
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool alarmBuzzer(const Alarm &alarm, uint32_t now) {
+  uint32_t inState = now - alarm.enteredAt;
+
+  // Latest cadence for this state that has started
+  Cadence cadence;
+  bool found = false;
+  for (uint8_t i = 0; i < cadenceCount; i++) {
+    Cadence entry;
+    memcpy_P(&entry, &cadences[i], sizeof(entry));
+    if (entry.state == alarm.state && entry.afterMs <= inState) {
+      cadence = entry;
+      found = true;
+    }
+  }
+  if (!found) return false;
+  if (cadence.offMs == 0) return true;
+  uint32_t phase = (inState - cadence.afterMs) % (cadence.onMs + cadence.offMs);
+  return phase < cadence.onMs;
+}
+
+const char *alarmStateName(AlarmState state) {
+  switch (state) {
+    case ALARM_COOLDOWN:  return "cooldown";
+    case ALARM_ARMED:     return "armed";
+    case ALARM_PRE_ALARM: return "pre-alarm";
+    case ALARM_TRIGGERED: return "triggered";
+    case ALARM_LATCHED:   return "latched";
+    default:              return "disarmed";
+  }
+}
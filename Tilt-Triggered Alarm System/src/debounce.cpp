@@ -0,0 +1,50 @@
+#include "debounce.h"
+
+void debounceBegin(Debouncer &debouncer, uint8_t stableSamples,
+                   uint16_t windowSamples, bool open) {
+  debouncer.stableSamples = stableSamples > 0 ? stableSamples : 1;
+  debouncer.count = 0;
+  debouncer.state = open;
+  debouncer.lastRaw = open;
+  debouncer.settling = 0;
+  debouncer.settled = 0;
+  debouncer.windowSamples = windowSamples;
+  debouncer.windowLeft = windowSamples;
+  debouncer.transitions = 0;
+  debouncer.vibration = 0;
+}
+
+bool debounceSample(Debouncer &debouncer, bool open) {
+  if (open != debouncer.lastRaw) {
+    debouncer.lastRaw = open;
+    debouncer.transitions++;
+  }
+  if (--debouncer.windowLeft == 0) {
+    debouncer.vibration = debouncer.transitions;
+    debouncer.transitions = 0;
+    debouncer.windowLeft = debouncer.windowSamples;
+  }
+
+  // A sample against the state counts one toward a change; one that agrees
+  // takes two back, so chatter that isn't mostly the other way drains away
+  if (open != debouncer.state) {
+    debouncer.count++;
+  } else if (debouncer.count > 2) {
+    debouncer.count -= 2;
+  } else {
+    debouncer.count = 0;
+  }
+
+  if (debouncer.count == 0) {
+    debouncer.settling = 0;
+    return false;
+  }
+  if (debouncer.settling < 0xFFFF) debouncer.settling++;
+  if (debouncer.count < debouncer.stableSamples) return false;
+
+  debouncer.state = open;
+  debouncer.count = 0;
+  debouncer.settled = debouncer.settling;
+  debouncer.settling = 0;
+  return true;
+}
@@ -10,64 +10,336 @@
  * Hardware Requirements:
  *    - Arduino Board
  *    - Active Buzzer (connected to pin 11)
- *    - Tilt Ball Switch Sensor (connected to pin 7)
+ *    - Tilt Ball Switch Sensor (connected to pin 18, external interrupt INT3)
  * 
  * Created: April 20, 2025
  * Author: Troy Johnson
  * 
  * Pin Configuration:
  *    - Digital Pin 11: Active Buzzer
- *    - Digital Pin 7:  Tilt Ball Switch
+ *    - Digital Pin 18: Tilt Ball Switch
  * 
  * Behavior:
- *    - When level: Buzzer OFF
- *    - When tilted: Buzzer ON
+ *    - The tilt switch is sampled every millisecond and debounced in a
+ *      Timer2 interrupt; a tilt counts once it has been stable for 50 ms
+ *      and is queued for loop() (see tilt_events.h)
+ *    - The alarm state machine (see alarm.h) turns tilts into alarms:
+ *      armed -> pre-alarm (10 s to disarm, chirping) -> triggered (at
+ *      least 30 s, getting more urgent) -> latched once level again, with
+ *      a reminder beep until reset. Arming or a reset waits 10 s first.
+ *    - The buzzer plays the cadence for the alarm state
+ *    - Switch chatter per 250 ms tells a jostled device from a tilted one
+ *    - Everything runs as tasks on the scheduler in lib/Scheduler and
+ *      nothing waits on the serial port, so a pass through loop() stays
+ *      under 2 ms (passes over that are counted)
+ *    - Armed, the board sleeps in power-down once it has been quiet for
+ *      2 s, with unused peripherals switched off; a tilt wakes it through
+ *      INT3, serial input through PCINT8 on RXD0 (see power_save.h)
  * 
  * Serial Communication:
  *    - Baud Rate: 9600
- *    - Outputs sensor state and buzzer status
+ *    - Outputs alarm state changes, tilt events, sensor state, buzzer
+ *      status, vibration, loop load and timing and sleep / wake counters
+ *    - Commands: arm, disarm, reset, entry [<seconds>]
+ *    - Serial is only started when there is something to print, and is off
+ *      while asleep: a tilt wakes it, and the entry delay is the time to
+ *      send "disarm". Serial input wakes it too (the wake-up characters are
+ *      lost), and it then stays awake 10 s for a command
  * 
  * IDE USED: Visual Studio Code with PlatformIO Extension
  * NOTE: Files via PlatformIO (C/CPP(C/C++ files)) are not compatible with Arduino IDE (ino files).
  ******************************************************************************/
 #include <Arduino.h>
+#include <scheduler.h>       // Task scheduler in lib/Scheduler
+#include "alarm.h"
+#include "tilt_events.h"
+#include "power_save.h"
 
 // Pin Definitions
 #define activeBuzzer 11    // Active buzzer connected to digital pin 11
-#define tiltBall 7         // Tilt ball switch sensor connected to digital pin 7
+#define tiltBall 18        // Tilt ball switch sensor on pin 18
+
+// The switch must read the same for this long before a tilt counts (ms)
+#define tiltStableMs 50
+
+// Stay awake this long after the last activity before sleeping (ms)
+#define awakeLingerMs 2000
+// ... or this long after serial input woke the board, to take a command
+#define commandLingerMs 10000
+
+// Alarm timing (ms)
+#define alarmEntryMs 10000     // Time to disarm after a tilt
+#define alarmMinMs 30000       // Shortest time the alarm sounds for
+#define alarmCooldownMs 10000  // Tilts ignored after arming or a reset
+
+// A pass through loop() should never take longer than this (us)
+#define loopBoundUs 2000
 
 // Global Variables
 int tiltSignal;           // Variable to store the tilt sensor reading
+Alarm alarm;
+AlarmConfig alarmConfig = {alarmEntryMs, alarmMinMs, alarmCooldownMs};
+AlarmState reportedState; // Last alarm state printed
+bool buzzerOn = false;
+unsigned long lastActivity = 0; // millis() when something last happened
+unsigned long lingerMs = awakeLingerMs; // Quiet time before sleeping
+
+// Serial command line
+char commandLine[16];
+uint8_t commandLength = 0;
+
+// Longest single pass through loop() (us), and passes over loopBoundUs
+unsigned long maxLoopMicros = 0;
+uint16_t loopOverruns = 0;
+
+// Status lines still to print, one per run of the status task
+uint8_t statusLine = 0;
+unsigned long nextStatusAt = 0;
+
+const char *activityName(TiltActivity activity) {
+  switch (activity) {
+    case TILT_JOSTLED: return "jostled";
+    case TILT_HELD:    return "tilted";
+    default:           return "still";
+  }
+}
+
+// Feed the debounced tilt state to the alarm, move on its timers and set
+// the buzzer to the cadence for its state
+void runAlarm() {
+  unsigned long now = millis();
+  bool tilted = tiltIsTilted();
+  if (tilted != alarm.tilted) {
+    alarmTilt(alarm, tilted, now);
+  }
+  alarmUpdate(alarm, alarmConfig, now);
+
+  bool on = alarmBuzzer(alarm, now);
+  if (on != buzzerOn) {
+    buzzerOn = on;
+    digitalWrite(activeBuzzer, on ? HIGH : LOW);
+  }
+}
+
+// Print alarm state changes and the confirmed tilt changes queued by the
+// interrupt, as far as the serial buffer has room for them; the rest wait
+// for the next run
+void printEvents() {
+  if (!tiltEventWaiting() && alarm.state == reportedState) return;
+  serialWake();
+  if (alarm.state != reportedState && Serial.availableForWrite() >= 20) {
+    reportedState = alarm.state;
+    Serial.print("Alarm: ");
+    Serial.println(alarmStateName(alarm.state));
+  }
+  TiltEvent event;
+  while (Serial.availableForWrite() >= 40 && tiltNextEvent(&event)) {
+    Serial.print(event.tilted ? "Tilted" : "Level");
+    Serial.print(" at ");
+    Serial.print(event.atMs);
+    Serial.print(" ms, settled in ");
+    Serial.print(event.settleMs);
+    Serial.println(" ms");
+  }
+}
+
+// "entry" shows the entry delay; "entry <seconds>" sets it
+void entryCommand(const char *args) {
+  while (*args == ' ') args++;
+  if (*args != '\0') {
+    if (!isDigit(*args)) {
+      Serial.println("Usage: entry <seconds>");
+      return;
+    }
+    alarmConfig.entryDelayMs = min(atol(args), 600L) * 1000;
+  }
+  Serial.print("Entry delay: ");
+  Serial.print(alarmConfig.entryDelayMs / 1000);
+  Serial.println(" s");
+}
+
+void runCommand(const char *line) {
+  unsigned long now = millis();
+  bool done;
+  if (strcmp(line, "arm") == 0) {
+    done = alarmArm(alarm, now);
+  } else if (strcmp(line, "disarm") == 0) {
+    done = alarmDisarm(alarm, now);
+  } else if (strcmp(line, "reset") == 0) {
+    done = alarmReset(alarm, now);
+  } else if (strncmp(line, "entry", 5) == 0) {
+    entryCommand(line + 5);
+    return;
+  } else {
+    Serial.println("Commands: arm, disarm, reset, entry [<s>]");
+    return;
+  }
+  if (!done) {
+    Serial.print("Not while ");
+    Serial.println(alarmStateName(alarm.state));
+  }
+  lastActivity = now;
+}
+
+// Collect serial input without blocking and run each complete line. Input
+// is only read while the longest reply fits in the serial buffer.
+void pollSerialCommands() {
+  while (Serial.available() > 0 && Serial.availableForWrite() >= 48) {
+    char ch = Serial.read();
+    lastActivity = millis();
+    if (ch == '\n' || ch == '\r') {
+      if (commandLength > 0) {
+        commandLine[commandLength] = '\0';
+        runCommand(commandLine);
+        commandLength = 0;
+      }
+    } else if (commandLength < sizeof(commandLine) - 1) {
+      commandLine[commandLength++] = ch;
+    }
+  }
+}
+
+void reportStatus();
+
+enum { TASK_ALARM, TASK_EVENTS, TASK_COMMANDS, TASK_REPORT, TASK_COUNT };
+
+// Run, period (us), priority
+Task tasks[TASK_COUNT] = {
+  {runAlarm, 5000, 0},             // Alarm and buzzer, every 5 ms
+  {printEvents, 10000, 1},         // Alarm and tilt events, every 10 ms
+  {pollSerialCommands, 20000, 2},  // Commands
+  {reportStatus, 50000, 3},        // Status once a second, a line a run
+};
+
+Scheduler scheduler(tasks, TASK_COUNT, micros);
+
+// Print the alarm, sensor and buzzer state, how busy the loop is and the
+// sleep counters. One line is printed per run, and only once the serial
+// buffer has room for all of it (the longest is 57 bytes), so a status never
+// waits on the port.
+void reportStatus() {
+  if (statusLine == 0 && (long)(millis() - nextStatusAt) < 0) return;
+  serialWake();
+  if (Serial.availableForWrite() < 57) return;
+
+  TiltWakeStats wakes = tiltWakeStats();
+  switch (statusLine) {
+    case 0:
+      nextStatusAt = millis() + 1000;
+      Serial.print(buzzerOn ? "Buzzer Activated" : "Buzzer Inactive");
+      Serial.print(", alarm: ");
+      Serial.print(alarmStateName(alarm.state));
+      Serial.print(" for ");
+      Serial.print((millis() - alarm.enteredAt) / 1000);
+      Serial.println(" s");
+      break;
+    case 1:
+      tiltSignal = tiltIsTilted() ? 1 : 0;
+      Serial.print("Signal Val: ");
+      Serial.print(tiltSignal);
+      Serial.print(", vibration: ");
+      Serial.print(tiltVibration());
+      Serial.print(" (");
+      Serial.print(activityName(tiltActivity()));
+      Serial.println(")");
+      break;
+    case 2: {
+      uint32_t misses = 0;
+      for (uint8_t id = 0; id < TASK_COUNT; id++) {
+        misses += scheduler.task(id).misses;
+      }
+      Serial.print("Loop load: ");
+      Serial.print(scheduler.occupancy() / 10);
+      Serial.print('.');
+      Serial.print(scheduler.occupancy() % 10);
+      Serial.print("%, missed: ");
+      Serial.print(misses);
+      Serial.print(", dropped: ");
+      Serial.println(tiltDropped());
+      break;
+    }
+    case 3:
+      Serial.print("Loop max: ");
+      Serial.print(maxLoopMicros);
+      Serial.print(" us, over ");
+      Serial.print(loopBoundUs);
+      Serial.print(" us: ");
+      Serial.println(loopOverruns);
+      break;
+    case 4:
+      Serial.print("Sleeps: ");
+      Serial.print(powerStats().sleeps);
+      Serial.print(", awake: ");
+      Serial.print(millis() / 1000);
+      Serial.println(" s");
+      break;
+    default:
+      Serial.print("Wakes: ");
+      Serial.print(wakes.wakes);
+      Serial.print(" (");
+      Serial.print(wakes.falseWakes);
+      Serial.print(" false), wake to tilt: ");
+      Serial.print(wakes.lastConfirmMs);
+      Serial.print('/');
+      Serial.print(wakes.maxConfirmMs);
+      Serial.println(" ms");
+      break;
+  }
+  statusLine = statusLine < 5 ? statusLine + 1 : 0;
+}
+
+// Sleep until the next tilt or serial input. Serial is shut down first; it
+// starts again when something is printed, or straight away when serial input
+// woke the board, which then stays up for a command.
+void sleepUntilTilt() {
+  serialSleep();
+  noInterrupts();
+  if (tiltArmWake()) {
+    powerDown();
+  } else {
+    interrupts();
+  }
+  lingerMs = awakeLingerMs;
+  if (powerWokeBySerial()) {
+    serialWake();
+    lingerMs = commandLingerMs;
+  }
+  lastActivity = millis();
+}
 
 void setup() {
-  // Initialize the active buzzer pin as output
-  pinMode(activeBuzzer, OUTPUT);
-  digitalWrite(activeBuzzer, LOW);    // Initially set buzzer to OFF
-  
-  // Initialize the tilt sensor pin as input with internal pull-up resistor
-  pinMode(tiltBall, INPUT);
-  digitalWrite(tiltBall, HIGH);       // Enable internal pull-up resistor
-  
-  // Initialize serial communication for debugging
-  Serial.begin(9600);                 // Start serial at 9600 baud rate
+  // Switch off unused peripherals; serial communication for debugging
+  // starts at 9600 baud when there is something to print
+  powerBegin(9600);
+
+  // Buzzer output (initially OFF), tilt input with internal pull-up, and the
+  // Timer2 sampling interrupt that debounces the switch. The buzzer is left
+  // to the alarm.
+  tiltBegin(tiltBall, activeBuzzer, tiltStableMs);
+  tiltFollowBuzzer(false);
+
+  // Armed from power-up, after the cooldown
+  alarmBegin(alarm, millis());
+  reportedState = alarm.state;
+  alarmArm(alarm, millis());
+
+  scheduler.begin();
 }
 
 void loop() {
-  // Read the current state of the tilt sensor
-  tiltSignal = digitalRead(tiltBall);
-  
-  // If tilt sensor is at rest (ball making contact, signal LOW)
-  if(tiltSignal == 0){
-    digitalWrite(activeBuzzer, LOW);     // Turn off the buzzer
-    Serial.println("Buzzer Inactive");
-    Serial.println("Signal Val: "+tiltSignal);
-    delay(1000);                       // Delay for 1 second to avoid rapid toggling
+  unsigned long loopStart = micros();
+  scheduler.run();
+  unsigned long loopTime = micros() - loopStart;
+  if (loopTime > maxLoopMicros) {
+    maxLoopMicros = loopTime;
   }
-  // If tilt sensor is triggered (ball broke contact, signal HIGH)
-  else{
-    digitalWrite(activeBuzzer, HIGH);    // Turn on the buzzer
-    Serial.println("Buzzer Activated");
-    Serial.println("Signal Val: "+tiltSignal);
-    delay(1000);                       // Delay for 1 second to avoid rapid toggling
+  if (loopTime > loopBoundUs) {
+    loopOverruns++;
+  }
+
+  if (!tiltSleepReady() || alarm.state != ALARM_ARMED) {
+    lastActivity = millis();
+  } else if (millis() - lastActivity >= lingerMs && serialIdle()) {
+    sleepUntilTilt();
   }
 }
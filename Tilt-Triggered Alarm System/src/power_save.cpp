@@ -0,0 +1,84 @@
+#include <Arduino.h>
+#include <avr/power.h>
+#include <avr/sleep.h>
+#include "power_save.h"
+
+static unsigned long serialBaud;
+static bool serialOn = false;
+static uint32_t wokeAtMs = 0;
+static PowerStats stats;
+static volatile bool serialWoke = false;
+
+// RXD0 changed while asleep
+ISR(PCINT1_vect) {
+  PCMSK1 &= ~_BV(PCINT8);
+  serialWoke = true;
+}
+
+void powerBegin(unsigned long baud) {
+  serialBaud = baud;
+
+  ADCSRA = 0;                  // ADC off before its clock goes
+  ACSR |= _BV(ACD);            // Analog comparator off
+  DIDR0 = 0xFF;                // No digital input buffers on A0-A15
+  DIDR2 = 0xFF;
+  power_adc_disable();
+  power_spi_disable();
+  power_twi_disable();
+  power_timer1_disable();
+  power_timer3_disable();
+  power_timer4_disable();
+  power_timer5_disable();
+  power_usart1_disable();
+  power_usart2_disable();
+  power_usart3_disable();
+  power_usart0_disable();      // Until there is something to print
+}
+
+void serialWake() {
+  if (serialOn) return;
+  power_usart0_enable();
+  Serial.begin(serialBaud);
+  serialOn = true;
+}
+
+bool serialIdle() {
+  return !serialOn || Serial.availableForWrite() >= SERIAL_TX_BUFFER_SIZE - 1;
+}
+
+void serialSleep() {
+  if (!serialOn) return;
+  Serial.flush();              // Wait for the last byte to leave
+  Serial.end();
+  power_usart0_disable();
+  serialOn = false;
+}
+
+void powerDown() {
+  uint32_t awake = millis() - wokeAtMs;
+  stats.lastAwakeMs = awake;
+  if (awake > stats.maxAwakeMs) stats.maxAwakeMs = awake;
+  stats.sleeps++;
+
+  serialWoke = false;
+  PCIFR = _BV(PCIF1);
+  PCMSK1 |= _BV(PCINT8);
+  PCICR |= _BV(PCIE1);
+
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  sleep_enable();
+  interrupts();                // The instruction after sei always runs, so
+  sleep_cpu();                 // no wake-up can slip in before the sleep
+  sleep_disable();
+  PCMSK1 &= ~_BV(PCINT8);
+
+  wokeAtMs = millis();
+}
+
+bool powerWokeBySerial() {
+  return serialWoke;
+}
+
+const PowerStats &powerStats() {
+  return stats;
+}
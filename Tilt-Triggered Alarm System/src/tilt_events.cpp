@@ -0,0 +1,189 @@
+#include <Arduino.h>
+#include "tilt_events.h"
+#include "debounce.h"
+
+uint8_t tiltJostleThreshold = 4;
+
+static volatile uint8_t *tiltIn;
+static uint8_t tiltMask;
+static volatile uint8_t *buzzerOut;
+static uint8_t buzzerMask;
+static volatile bool followBuzzer = true;
+
+static Debouncer debouncer;
+static volatile uint32_t sampleClock = 0; // ms, counted by the interrupt
+
+static TiltEvent queue[tiltQueueSize];
+static volatile uint8_t head = 0; // Written by the interrupt only
+static volatile uint8_t tail = 0; // Written by loop() only
+static volatile uint16_t dropped = 0;
+
+static uint8_t tiltInterrupt;
+static uint8_t wakeFlag;          // EIFR bit of the pin's external interrupt
+static volatile bool waking = false;
+static uint32_t wokeAt;
+static TiltWakeStats wakeStats;
+
+// debouncer and wakeStats belong to the interrupts; everything outside them
+// reads a copy taken with interrupts off.
+
+static void startSampling() {
+  TCNT2 = 0;
+  TIFR2 = _BV(OCF2A);
+  TIMSK2 = _BV(OCIE2A);
+}
+
+// Tilt edge while asleep
+static void onWake() {
+  detachInterrupt(tiltInterrupt);
+  if (followBuzzer && (*tiltIn & tiltMask)) {
+    *buzzerOut |= buzzerMask;      // Confirmed or undone below
+  }
+  waking = true;
+  wokeAt = sampleClock;
+  wakeStats.wakes++;
+  startSampling();
+}
+
+// Timer2 compare match, once a millisecond
+ISR(TIMER2_COMPA_vect) {
+  sampleClock++;
+  bool open = (*tiltIn & tiltMask) != 0;
+  bool changed = debounceSample(debouncer, open);
+
+  if (waking) {
+    if (changed) {
+      waking = false;
+      uint16_t confirmMs = sampleClock - wokeAt;
+      wakeStats.lastConfirmMs = confirmMs;
+      if (confirmMs > wakeStats.maxConfirmMs) wakeStats.maxConfirmMs = confirmMs;
+    } else if (debouncer.count == 0) {
+      waking = false;
+      wakeStats.falseWakes++;
+      if (followBuzzer) *buzzerOut &= ~buzzerMask;
+    }
+  }
+  if (!changed) return;
+
+  // Buzzer first, then the bookkeeping
+  if (followBuzzer) {
+    if (debouncer.state) {
+      *buzzerOut |= buzzerMask;
+    } else {
+      *buzzerOut &= ~buzzerMask;
+    }
+  }
+
+  uint8_t next = (head + 1) & (tiltQueueSize - 1);
+  if (next == tail) {
+    dropped++;
+    return;
+  }
+  queue[head].atMs = sampleClock;
+  queue[head].settleMs = debouncer.settled;
+  queue[head].tilted = debouncer.state;
+  head = next;
+}
+
+void tiltBegin(uint8_t tiltPin, uint8_t buzzerPin, uint8_t stableMs) {
+  pinMode(buzzerPin, OUTPUT);
+  digitalWrite(buzzerPin, LOW);
+  pinMode(tiltPin, INPUT_PULLUP);
+
+  tiltIn = portInputRegister(digitalPinToPort(tiltPin));
+  tiltMask = digitalPinToBitMask(tiltPin);
+  buzzerOut = portOutputRegister(digitalPinToPort(buzzerPin));
+  buzzerMask = digitalPinToBitMask(buzzerPin);
+  tiltInterrupt = digitalPinToInterrupt(tiltPin);
+  wakeFlag = (tiltPin >= 18 && tiltPin <= 21) ? _BV(21 - tiltPin) : 0;
+
+  // Start level; a tilted switch is confirmed after stableMs like any other
+  debounceBegin(debouncer, stableMs, tiltWindowMs, false);
+
+  // Timer2: CTC, clk/64, 250 counts = 1 ms at 16 MHz
+  noInterrupts();
+  TCCR2A = _BV(WGM21);
+  TCCR2B = _BV(CS22);
+  OCR2A = F_CPU / 64 / 1000 - 1;
+  startSampling();
+  interrupts();
+}
+
+void tiltSetStableMs(uint8_t stableMs) {
+  noInterrupts();
+  bool open = debouncer.state;
+  debounceBegin(debouncer, stableMs, tiltWindowMs, open);
+  interrupts();
+}
+
+void tiltFollowBuzzer(bool follow) {
+  followBuzzer = follow;
+}
+
+bool tiltNextEvent(TiltEvent *event) {
+  uint8_t at = tail;
+  if (at == head) return false;
+  *event = queue[at];
+  tail = (at + 1) & (tiltQueueSize - 1);
+  return true;
+}
+
+bool tiltEventWaiting() {
+  return head != tail;
+}
+
+bool tiltIsTilted() {
+  noInterrupts();
+  bool tilted = debouncer.state;
+  interrupts();
+  return tilted;
+}
+
+uint16_t tiltVibration() {
+  noInterrupts();
+  uint16_t vibration = debouncer.vibration;
+  interrupts();
+  return vibration;
+}
+
+TiltActivity tiltActivity() {
+  if (tiltVibration() >= tiltJostleThreshold) return TILT_JOSTLED;
+  return tiltIsTilted() ? TILT_HELD : TILT_STILL;
+}
+
+uint16_t tiltDropped() {
+  noInterrupts();
+  uint16_t count = dropped;
+  interrupts();
+  return count;
+}
+
+bool tiltSleepReady() {
+  noInterrupts();
+  bool ready = !debouncer.state && debouncer.count == 0 &&
+               debouncer.transitions == 0 && debouncer.vibration == 0 &&
+               !waking && head == tail && (*tiltIn & tiltMask) == 0;
+  interrupts();
+  return ready;
+}
+
+bool tiltArmWake() {
+  if (wakeFlag == 0 || (*tiltIn & tiltMask)) return false;
+  TIMSK2 = 0;
+  attachInterrupt(tiltInterrupt, onWake, RISING);
+  EIFR = wakeFlag;
+  // An edge between the check above and here would have been missed
+  if (*tiltIn & tiltMask) {
+    detachInterrupt(tiltInterrupt);
+    startSampling();
+    return false;
+  }
+  return true;
+}
+
+TiltWakeStats tiltWakeStats() {
+  noInterrupts();
+  TiltWakeStats stats = wakeStats;
+  interrupts();
+  return stats;
+}
@@ -0,0 +1,155 @@
+// Just enough of the Arduino core to build the alarm on the host.
+//
+// Time only moves when a test calls hostAdvance(), or when the code under
+// test is charged for something: Serial models the 63 free bytes of the
+// UART's TX buffer draining at the baud rate, so a write into a full buffer
+// waits (and is counted) as it would on the board. Serial.writeUs and
+// Print::numberUs charge a rough AVR cost per byte written and per number
+// formatted; both are 0 unless a test sets them.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define F_CPU 16000000UL
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define _BV(bit) (1 << (bit))
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define memcpy_P memcpy
+
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+
+inline unsigned long &hostMicros() {
+  static unsigned long now = 0;
+  return now;
+}
+inline void hostAdvance(unsigned long us) { hostMicros() += us; }
+inline unsigned long micros() { return hostMicros(); }
+inline unsigned long millis() { return hostMicros() / 1000; }
+
+inline uint8_t *hostPinLevels() {
+  static uint8_t levels[80];
+  return levels;
+}
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t value) { hostPinLevels()[pin] = value; }
+inline int digitalRead(uint8_t pin) { return hostPinLevels()[pin]; }
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class Print {
+public:
+  unsigned numberUs = 0;
+  virtual size_t write(uint8_t ch) = 0;
+  size_t write(const char *text) {
+    size_t n = 0;
+    while (*text) n += write((uint8_t)*text++);
+    return n;
+  }
+  size_t print(const char *text) { return write(text); }
+  size_t print(char ch) { return write((uint8_t)ch); }
+  size_t print(long value) { return number("%ld", value); }
+  size_t print(int value) { return number("%ld", value); }
+  size_t print(unsigned long value) { return unumber(value); }
+  size_t print(unsigned int value) { return unumber(value); }
+  size_t print(unsigned char value) { return unumber(value); }
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T value) { return print(value) + println(); }
+
+private:
+  size_t number(const char *format, long value) {
+    char text[24];
+    snprintf(text, sizeof(text), format, value);
+    hostAdvance(numberUs);
+    return write(text);
+  }
+  size_t unumber(unsigned long value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%lu", value);
+    hostAdvance(numberUs);
+    return write(text);
+  }
+};
+
+class HardwareSerial : public Print {
+public:
+  static const int txSize = 63;
+  double byteUs = 1041.7;        // 9600 baud, 10 bits a byte
+  unsigned writeUs = 0;
+  unsigned readUs = 0;
+  std::string sent;
+  std::string received;          // Input still to be read
+  unsigned long blockedWrites = 0;
+  unsigned long blockedUs = 0;   // Time spent waiting in write()
+
+  void begin(unsigned long baud) { byteUs = 10e6 / baud; }
+  void end() {}
+  void flush() {
+    while (availableForWrite() < txSize) hostAdvance(100);
+  }
+  int availableForWrite() {
+    drain();
+    return txSize - queued;
+  }
+  size_t write(uint8_t ch) override {
+    drain();
+    if (queued >= txSize) {
+      unsigned long wait = (unsigned long)(drainedAt + byteUs - micros()) + 1;
+      hostAdvance(wait);
+      blockedUs += wait;
+      blockedWrites++;
+      drain();
+    }
+    queued++;
+    hostAdvance(writeUs);
+    sent += (char)ch;
+    return 1;
+  }
+  using Print::write;
+  int available() { return received.size(); }
+  int read() {
+    if (received.empty()) return -1;
+    char ch = received[0];
+    received.erase(0, 1);
+    hostAdvance(readUs);
+    return ch;
+  }
+
+private:
+  int queued = 0;
+  double drainedAt = 0;
+  void drain() {
+    while (queued > 0 && micros() >= drainedAt + byteUs) {
+      queued--;
+      drainedAt += byteUs;
+    }
+    if (queued == 0) drainedAt = micros();
+  }
+};
+
+inline HardwareSerial &hostSerial() {
+  static HardwareSerial serial;
+  return serial;
+}
+#define Serial hostSerial()
+
+#endif
@@ -0,0 +1,199 @@
+// Every alarm state transition and the buzzer cadences, on a virtual clock:
+// the alarm only ever sees the times it is handed.
+#include <unity.h>
+#include <alarm.h>
+
+static const AlarmConfig config = {10000, 30000, 10000};
+static Alarm alarm;
+static uint32_t t;
+
+// Arm and let the cooldown pass; t is then the moment it became ARMED
+static void armed() {
+  alarmArm(alarm, t);
+  t += config.cooldownMs;
+  TEST_ASSERT_TRUE(alarmUpdate(alarm, config, t));
+  TEST_ASSERT_EQUAL(ALARM_ARMED, alarm.state);
+}
+
+// From ARMED: tilt, sit out the entry delay; t is then the trigger time
+static void triggered() {
+  armed();
+  alarmTilt(alarm, true, t);
+  t += config.entryDelayMs;
+  TEST_ASSERT_TRUE(alarmUpdate(alarm, config, t));
+  TEST_ASSERT_EQUAL(ALARM_TRIGGERED, alarm.state);
+}
+
+void setUp(void) {
+  t = 1000;
+  alarmBegin(alarm, t);
+}
+
+void tearDown(void) {}
+
+void test_disarmed_ignores_tilts_and_commands(void) {
+  TEST_ASSERT_EQUAL(ALARM_DISARMED, alarm.state);
+  alarmTilt(alarm, true, t);
+  TEST_ASSERT_FALSE(alarmUpdate(alarm, config, t + 100000));
+  TEST_ASSERT_EQUAL(ALARM_DISARMED, alarm.state);
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t));
+  TEST_ASSERT_FALSE(alarmReset(alarm, t));
+  TEST_ASSERT_FALSE(alarmDisarm(alarm, t));
+}
+
+void test_cooldown_to_armed(void) {
+  TEST_ASSERT_TRUE(alarmArm(alarm, t));
+  TEST_ASSERT_EQUAL(ALARM_COOLDOWN, alarm.state);
+  TEST_ASSERT_FALSE(alarmArm(alarm, t));
+  alarmTilt(alarm, true, t + 100);   // Ignored: putting the device down
+  alarmTilt(alarm, false, t + 200);
+  TEST_ASSERT_FALSE(alarmUpdate(alarm, config, t + config.cooldownMs - 1));
+  TEST_ASSERT_EQUAL(ALARM_COOLDOWN, alarm.state);
+  TEST_ASSERT_TRUE(alarmUpdate(alarm, config, t + config.cooldownMs));
+  TEST_ASSERT_EQUAL(ALARM_ARMED, alarm.state);
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t + config.cooldownMs));
+}
+
+void test_cooldown_ends_tilted(void) {
+  alarmArm(alarm, t);
+  alarmTilt(alarm, true, t + 100);
+  TEST_ASSERT_TRUE(alarmUpdate(alarm, config, t + config.cooldownMs));
+  TEST_ASSERT_EQUAL(ALARM_PRE_ALARM, alarm.state);
+}
+
+void test_pre_alarm_cadence_and_disarm(void) {
+  armed();
+  alarmTilt(alarm, true, t);
+  TEST_ASSERT_EQUAL(ALARM_PRE_ALARM, alarm.state);
+  // 100 ms chirp a second, every half second after 5 s
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t));
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t + 99));
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t + 100));
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t + 999));
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t + 1000));
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t + 5000));
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t + 5100));
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t + 5500));
+
+  TEST_ASSERT_TRUE(alarmDisarm(alarm, t + 3000));
+  TEST_ASSERT_EQUAL(ALARM_DISARMED, alarm.state);
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t + 3000));
+  TEST_ASSERT_FALSE(alarmUpdate(alarm, config, t + 100000));
+}
+
+// Level again during the entry delay still triggers: the tilt happened
+void test_pre_alarm_to_triggered(void) {
+  armed();
+  alarmTilt(alarm, true, t);
+  alarmTilt(alarm, false, t + 500);
+  TEST_ASSERT_FALSE(alarmUpdate(alarm, config, t + config.entryDelayMs - 1));
+  TEST_ASSERT_TRUE(alarmUpdate(alarm, config, t + config.entryDelayMs));
+  TEST_ASSERT_EQUAL(ALARM_TRIGGERED, alarm.state);
+}
+
+void test_triggered_cadence(void) {
+  triggered();
+  // 500/500, then 200/200 after 15 s, continuous after 45 s
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t));
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t + 500));
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t + 1000));
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t + 15000));
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t + 15200));
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t + 15400));
+  for (uint32_t after = 45000; after < 60000; after += 7) {
+    TEST_ASSERT_TRUE(alarmBuzzer(alarm, t + after));
+  }
+}
+
+void test_triggered_to_latched(void) {
+  triggered();
+  // Level, but the alarm sounds for its minimum time
+  alarmTilt(alarm, false, t + 1000);
+  TEST_ASSERT_FALSE(alarmUpdate(alarm, config, t + config.minAlarmMs - 1));
+  TEST_ASSERT_TRUE(alarmUpdate(alarm, config, t + config.minAlarmMs));
+  TEST_ASSERT_EQUAL(ALARM_LATCHED, alarm.state);
+  t += config.minAlarmMs;
+  // A reminder beep every 5 s, for as long as nobody resets it
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t));
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t + 100));
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t + 5000));
+  TEST_ASSERT_FALSE(alarmUpdate(alarm, config, t + 1000000));
+  TEST_ASSERT_EQUAL(ALARM_LATCHED, alarm.state);
+}
+
+void test_triggered_while_tilted(void) {
+  triggered();
+  TEST_ASSERT_FALSE(alarmUpdate(alarm, config, t + 90000));
+  TEST_ASSERT_EQUAL(ALARM_TRIGGERED, alarm.state);
+  alarmTilt(alarm, false, t + 90000);
+  TEST_ASSERT_TRUE(alarmUpdate(alarm, config, t + 90001));
+  TEST_ASSERT_EQUAL(ALARM_LATCHED, alarm.state);
+}
+
+void test_latched_retriggers_on_tilt(void) {
+  triggered();
+  alarmTilt(alarm, false, t);
+  t += config.minAlarmMs;
+  alarmUpdate(alarm, config, t);
+  TEST_ASSERT_EQUAL(ALARM_LATCHED, alarm.state);
+  alarmTilt(alarm, true, t + 2000);
+  TEST_ASSERT_EQUAL(ALARM_TRIGGERED, alarm.state);
+  TEST_ASSERT_TRUE(alarmBuzzer(alarm, t + 2000));
+}
+
+void test_latched_reset_and_disarm(void) {
+  triggered();
+  alarmTilt(alarm, false, t);
+  t += config.minAlarmMs;
+  alarmUpdate(alarm, config, t);
+  TEST_ASSERT_FALSE(alarmArm(alarm, t));
+  TEST_ASSERT_TRUE(alarmReset(alarm, t));
+  TEST_ASSERT_EQUAL(ALARM_COOLDOWN, alarm.state);
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t + 10));
+  TEST_ASSERT_FALSE(alarmReset(alarm, t));
+
+  TEST_ASSERT_TRUE(alarmDisarm(alarm, t));
+  TEST_ASSERT_EQUAL(ALARM_DISARMED, alarm.state);
+}
+
+// Disarm works from every armed state
+void test_disarm_from_every_state(void) {
+  alarmArm(alarm, t);
+  TEST_ASSERT_TRUE(alarmDisarm(alarm, t));
+  armed();
+  TEST_ASSERT_TRUE(alarmDisarm(alarm, t));
+  armed();
+  alarmTilt(alarm, true, t);
+  TEST_ASSERT_TRUE(alarmDisarm(alarm, t));
+  alarmTilt(alarm, false, t);
+  triggered();
+  TEST_ASSERT_TRUE(alarmDisarm(alarm, t));
+  TEST_ASSERT_FALSE(alarmBuzzer(alarm, t));
+}
+
+// Timers keep working across the millis() wrap
+void test_millis_wrap(void) {
+  uint32_t start = 0xFFFFF000u;
+  alarmBegin(alarm, start);
+  alarmArm(alarm, start);
+  TEST_ASSERT_FALSE(alarmUpdate(alarm, config, 0x1000u));
+  TEST_ASSERT_TRUE(alarmUpdate(alarm, config, start + config.cooldownMs));
+  TEST_ASSERT_EQUAL(ALARM_ARMED, alarm.state);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_disarmed_ignores_tilts_and_commands);
+  RUN_TEST(test_cooldown_to_armed);
+  RUN_TEST(test_cooldown_ends_tilted);
+  RUN_TEST(test_pre_alarm_cadence_and_disarm);
+  RUN_TEST(test_pre_alarm_to_triggered);
+  RUN_TEST(test_triggered_cadence);
+  RUN_TEST(test_triggered_to_latched);
+  RUN_TEST(test_triggered_while_tilted);
+  RUN_TEST(test_latched_retriggers_on_tilt);
+  RUN_TEST(test_latched_reset_and_disarm);
+  RUN_TEST(test_disarm_from_every_state);
+  RUN_TEST(test_millis_wrap);
+  return UNITY_END();
+}
@@ -0,0 +1,191 @@
+// The debouncer on synthetic switch traces, sampled at 1 kHz: sustained
+// tilts with chatter at both ends, and jostles of the ball rattling about.
+// A tilt must be confirmed exactly once each way, soon after its chatter;
+// a jostle must not be taken for a tilt; and the vibration count must tell
+// the two apart.
+#include <stdio.h>
+#include <unity.h>
+#include <debounce.h>
+
+static const uint16_t windowMs = 250;
+static const uint16_t jostleThreshold = 4;
+static const int traces = 2000;
+
+static uint32_t seed;
+
+static uint32_t nextRandom() {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+static uint32_t between(uint32_t low, uint32_t high) {
+  return low + nextRandom() % (high - low + 1);
+}
+
+static uint32_t earlier(uint32_t a, uint32_t b) { return a < b ? a : b; }
+
+// One trace: closed, then a tilt or a jostle, then closed again
+struct Trace {
+  bool jostle;
+  uint32_t start, end;       // Tilt: open from start; jostle: rattling
+  uint16_t onsetMs, releaseMs;
+  uint32_t length;
+  uint8_t level[6000];       // Raw switch, per ms (1 = open)
+
+  void make(bool isJostle) {
+    jostle = isJostle;
+    start = between(300, 600);
+    if (jostle) {
+      end = start + between(500, 2000);
+      for (uint32_t ms = 0; ms < start; ms++) level[ms] = 0;
+      // The ball makes or breaks contact at the end of every segment
+      uint32_t ms = start;
+      uint8_t open = 0;
+      while (ms < end) {
+        open = !open;
+        for (uint32_t stop = earlier(ms + between(1, 12), end); ms < stop; ms++) level[ms] = open;
+      }
+    } else {
+      onsetMs = between(5, 40);
+      releaseMs = between(5, 40);
+      end = start + onsetMs + between(500, 2000);
+      for (uint32_t ms = 0; ms < start; ms++) level[ms] = 0;
+      chatter(start, start + onsetMs, 3);
+      for (uint32_t ms = start + onsetMs; ms < end; ms++) level[ms] = 1;
+      chatter(end, end + releaseMs, 1);
+      end += releaseMs;
+    }
+    length = end + 600;
+    for (uint32_t ms = end; ms < length; ms++) level[ms] = 0;
+  }
+
+  // Segments of 1-4 ms, open with odds openIn4 in 4
+  void chatter(uint32_t from, uint32_t to, uint8_t openIn4) {
+    uint32_t ms = from;
+    while (ms < to) {
+      uint8_t open = ms == from ? 1 : nextRandom() % 4 < openIn4;
+      for (uint32_t stop = earlier(ms + between(1, 4), to); ms < stop; ms++) level[ms] = open;
+    }
+  }
+};
+
+static Trace trace;
+
+struct Result {
+  int tilts, jostles;
+  int tiltsExact;        // Confirmed exactly once each way
+  int jostlesConfirmed;  // Taken for a tilt at least once
+  uint32_t worstOnsetLag, worstReleaseLag; // After the chatter ended (ms)
+  int windows, windowsWrong;
+};
+
+static Result run(uint8_t stableMs) {
+  Result result = {};
+  seed = 48;
+  for (int i = 0; i < traces; i++) {
+    trace.make(i % 2 == 1);
+    Debouncer debouncer;
+    debounceBegin(debouncer, stableMs, windowMs, false);
+
+    int opens = 0, closes = 0;
+    uint32_t openedAt = 0, closedAt = 0;
+    for (uint32_t ms = 0; ms < trace.length; ms++) {
+      if (debounceSample(debouncer, trace.level[ms])) {
+        if (debouncer.state) {
+          opens++;
+          openedAt = ms;
+        } else {
+          closes++;
+          closedAt = ms;
+        }
+      }
+
+      // A window that lies wholly inside one phase of the trace must be
+      // classified as that phase: rattling or not
+      if (debouncer.windowLeft == debouncer.windowSamples && ms + 1 >= windowMs) {
+        uint32_t first = ms + 1 - windowMs;
+        bool insideRattle = trace.jostle && first >= trace.start && ms < trace.end;
+        bool insideQuiet = trace.jostle ? (ms < trace.start || first >= trace.end)
+                                        : (ms < trace.start ||
+                                           (first >= trace.start + trace.onsetMs &&
+                                            ms < trace.end - trace.releaseMs) ||
+                                           first >= trace.end);
+        if (insideRattle || insideQuiet) {
+          result.windows++;
+          bool jostled = debouncer.vibration >= jostleThreshold;
+          if (jostled != insideRattle) result.windowsWrong++;
+        }
+      }
+    }
+
+    if (trace.jostle) {
+      result.jostles++;
+      if (opens > 0) result.jostlesConfirmed++;
+    } else {
+      result.tilts++;
+      if (opens == 1 && closes == 1) {
+        result.tiltsExact++;
+        uint32_t onsetLag = openedAt - (trace.start + trace.onsetMs);
+        uint32_t releaseLag = closedAt - trace.end;
+        if (onsetLag > result.worstOnsetLag) result.worstOnsetLag = onsetLag;
+        if (releaseLag > result.worstReleaseLag) result.worstReleaseLag = releaseLag;
+      }
+    }
+  }
+  return result;
+}
+
+static void report(uint8_t stableMs, const Result &result) {
+  char message[120];
+  snprintf(message, sizeof(message),
+           "%u ms: tilts %d/%d exact, jostles taken for tilts %d/%d, windows wrong %d/%d",
+           stableMs, result.tiltsExact, result.tilts, result.jostlesConfirmed,
+           result.jostles, result.windowsWrong, result.windows);
+  TEST_MESSAGE(message);
+}
+
+// The sketch's 50 ms window: every tilt once each way, within the window of
+// the chatter ending, and no jostle taken for a tilt
+void test_sketch_window(void) {
+  Result result = run(50);
+  report(50, result);
+  TEST_ASSERT_EQUAL(result.tilts, result.tiltsExact);
+  TEST_ASSERT_LESS_OR_EQUAL(49, result.worstOnsetLag);
+  TEST_ASSERT_LESS_OR_EQUAL(49, result.worstReleaseLag);
+  TEST_ASSERT_EQUAL(0, result.jostlesConfirmed);
+  TEST_ASSERT_EQUAL(0, result.windowsWrong);
+}
+
+// Shorter windows let jostles through, which is why the sketch uses 50 ms
+void test_short_windows(void) {
+  Result at30 = run(30);
+  report(30, at30);
+  Result at10 = run(10);
+  report(10, at10);
+  TEST_ASSERT_GREATER_THAN(0, at30.jostlesConfirmed);
+  TEST_ASSERT_GREATER_THAN(at30.jostlesConfirmed, at10.jostlesConfirmed);
+}
+
+// A single glitch never gets through; a clean change takes exactly the window
+void test_glitch_and_clean_change(void) {
+  Debouncer debouncer;
+  debounceBegin(debouncer, 50, windowMs, false);
+  for (int ms = 0; ms < 100; ms++) {
+    TEST_ASSERT_FALSE(debounceSample(debouncer, ms % 20 == 0));
+  }
+  for (int ms = 1; ms < 50; ms++) TEST_ASSERT_FALSE(debounceSample(debouncer, true));
+  TEST_ASSERT_TRUE(debounceSample(debouncer, true));
+  TEST_ASSERT_TRUE(debouncer.state);
+  TEST_ASSERT_EQUAL_UINT16(50, debouncer.settled);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sketch_window);
+  RUN_TEST(test_short_windows);
+  RUN_TEST(test_glitch_and_clean_change);
+  return UNITY_END();
+}
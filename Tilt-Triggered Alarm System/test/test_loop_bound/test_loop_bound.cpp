@@ -0,0 +1,113 @@
+// main.cpp on the host for an hour of virtual time: the 63-byte TX buffer
+// draining at 9600 baud, random tilts and serial commands. No pass through
+// loop() may wait on the port or take longer than loopBoundUs.
+//
+// The time charged is a rough AVR cost model: 6 us per byte written, 20 us
+// per number formatted, 2 us per byte read and 40 us of overhead a pass.
+// tilt_events and power_save are replaced below, so the switch and sleep are
+// under the test's control.
+#include <unity.h>
+#include "../../src/main.cpp"
+
+static const char *const commands[] = {
+  "arm\n", "disarm\n", "reset\n", "entry 3\n", "entry\n", "bogus\n",
+};
+
+static uint32_t seed;
+
+static uint32_t nextRandom() {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+// tilt_events: a debounced switch the test sets, and its event queue
+static bool switchTilted = false;
+static TiltEvent queued[tiltQueueSize];
+static uint8_t queuedCount = 0;
+
+static void setTilt(bool tilted) {
+  if (tilted == switchTilted) return;
+  switchTilted = tilted;
+  if (queuedCount < tiltQueueSize) {
+    queued[queuedCount++] = {(uint32_t)millis(), tiltStableMs, tilted};
+  }
+}
+
+void tiltBegin(uint8_t, uint8_t, uint8_t) {}
+void tiltFollowBuzzer(bool) {}
+bool tiltNextEvent(TiltEvent *event) {
+  if (queuedCount == 0) return false;
+  *event = queued[0];
+  memmove(queued, queued + 1, --queuedCount * sizeof(TiltEvent));
+  return true;
+}
+bool tiltEventWaiting() { return queuedCount > 0; }
+bool tiltIsTilted() { return switchTilted; }
+uint16_t tiltVibration() { return 0; }
+TiltActivity tiltActivity() { return switchTilted ? TILT_HELD : TILT_STILL; }
+uint16_t tiltDropped() { return 0; }
+bool tiltSleepReady() { return !switchTilted && queuedCount == 0; }
+bool tiltArmWake() { return true; }
+TiltWakeStats tiltWakeStats() { return TiltWakeStats(); }
+
+// power_save: sleep returns at once, as if woken by the next pass
+static PowerStats power;
+
+void powerBegin(unsigned long) {}
+void serialWake() {}
+bool serialIdle() { return Serial.availableForWrite() == HardwareSerial::txSize; }
+void serialSleep() { Serial.flush(); }
+void powerDown() { power.sleeps++; }
+bool powerWokeBySerial() { return false; }
+const PowerStats &powerStats() { return power; }
+
+void setUp(void) {
+  Serial.writeUs = 6;
+  Serial.numberUs = 20;
+  Serial.readUs = 2;
+}
+
+void tearDown(void) {}
+
+void test_loop_bound(void) {
+  setup();
+  seed = 7;
+  uint16_t visits[ALARM_LATCHED + 1] = {};
+  AlarmState last = alarm.state;
+  unsigned long nextCommandAt = 0;
+  for (unsigned long second = 0; second < 3600;) {
+    loop();
+    hostAdvance(40);
+    second = millis() / 1000;
+
+    if (nextRandom() % 400000 == 0) setTilt(!switchTilted);
+    if (second >= nextCommandAt) {
+      Serial.received += commands[nextRandom() % 6];
+      nextCommandAt = second + 20 + nextRandom() % 120;
+    }
+    if (alarm.state != last) {
+      visits[alarm.state]++;
+      last = alarm.state;
+    }
+  }
+
+  char message[96];
+  snprintf(message, sizeof(message),
+           "max loop %lu us, over %u us: %u, blocked writes %lu, sleeps %lu",
+           maxLoopMicros, loopBoundUs, loopOverruns, Serial.blockedWrites,
+           (unsigned long)power.sleeps);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_OR_EQUAL(loopBoundUs, maxLoopMicros);
+  TEST_ASSERT_EQUAL_UINT16(0, loopOverruns);
+  TEST_ASSERT_EQUAL_UINT32(0, Serial.blockedWrites);
+  TEST_ASSERT_GREATER_THAN(0, power.sleeps);
+  // The hour has to have been through the alarm, not just idled armed
+  TEST_ASSERT_GREATER_THAN(0, visits[ALARM_TRIGGERED]);
+  TEST_ASSERT_GREATER_THAN(0, visits[ALARM_LATCHED]);
+}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_loop_bound);
+  return UNITY_END();
+}
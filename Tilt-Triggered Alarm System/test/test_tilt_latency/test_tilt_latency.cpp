@@ -0,0 +1,86 @@
+// Tilt to buzzer latency through the path the sketch uses: the switch
+// sampled into the debouncer at 1 kHz (the Timer2 interrupt), and the alarm
+// task, every 5 ms, turning the confirmed tilt into the pre-alarm chirp.
+#include <unity.h>
+#include <debounce.h>
+#include <alarm.h>
+
+static const uint8_t stableMs = 50;
+static const uint8_t alarmTaskMs = 5;
+static const AlarmConfig config = {10000, 30000, 10000};
+
+static uint32_t seed;
+
+static uint32_t nextRandom() {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+// Play a tilt onset: chatterMs of the ball rattling (segments of 1-4 ms,
+// mostly open), then open for good. Returns the ms from the first open
+// sample to the buzzer coming on, or -1 if it never does.
+static long tiltToBuzzer(uint16_t chatterMs, uint8_t taskPhase) {
+  Debouncer debouncer;
+  debounceBegin(debouncer, stableMs, 250, false);
+  Alarm alarm;
+  alarmBegin(alarm, 0);
+  alarmArm(alarm, 0);
+  alarmUpdate(alarm, config, config.cooldownMs);
+
+  const uint32_t onset = 20000;
+  bool open = false;
+  uint32_t segmentEnd = onset;
+  for (uint32_t ms = 0; ms < onset + chatterMs + 1000; ms++) {
+    if (ms >= onset + chatterMs) {
+      open = true;
+    } else if (ms >= segmentEnd) {
+      open = ms == onset || nextRandom() % 4 != 0;
+      segmentEnd = ms + 1 + nextRandom() % 4;
+    }
+    debounceSample(debouncer, open);
+
+    if (ms % alarmTaskMs == taskPhase) {
+      if (debouncer.state != alarm.tilted) alarmTilt(alarm, debouncer.state, ms);
+      alarmUpdate(alarm, config, ms);
+      if (alarmBuzzer(alarm, ms)) return ms - onset;
+    }
+  }
+  return -1;
+}
+
+// A clean tilt is confirmed on its 50th sample and heard at the next run
+// of the alarm task
+void test_clean_tilt(void) {
+  for (uint8_t phase = 0; phase < alarmTaskMs; phase++) {
+    long latency = tiltToBuzzer(0, phase);
+    TEST_ASSERT_GREATER_OR_EQUAL(stableMs - 1, latency);
+    TEST_ASSERT_LESS_OR_EQUAL(stableMs - 1 + alarmTaskMs - 1, latency);
+  }
+}
+
+// With chatter at the onset, the buzzer comes on no later than the window
+// after the chatter ends, plus the alarm task period
+void test_chattering_onset(void) {
+  seed = 1;
+  long worst = 0;
+  for (int trial = 0; trial < 2000; trial++) {
+    uint16_t chatterMs = 5 + nextRandom() % 36;
+    long latency = tiltToBuzzer(chatterMs, nextRandom() % alarmTaskMs);
+    TEST_ASSERT_NOT_EQUAL(-1, latency);
+    TEST_ASSERT_LESS_OR_EQUAL(chatterMs + stableMs - 1 + alarmTaskMs - 1, latency);
+    if (latency > worst) worst = latency;
+  }
+  char message[48];
+  snprintf(message, sizeof(message), "worst tilt to buzzer: %ld ms", worst);
+  TEST_MESSAGE(message);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_clean_tilt);
+  RUN_TEST(test_chattering_onset);
+  return UNITY_END();
+}